@@ -0,0 +1,136 @@
+/**
+ * HEAP ALLOCATION BENCHMARK
+ *
+ * Counts the heap allocations needed to build, send and read alerts.
+ * Counting needs every global operator new/delete replaced, which would
+ * slow and distort the rest of the program (one shared counter hit by
+ * every thread), so it lives in this separate binary instead.
+ *
+ * Each case has an allocation bound; the bench exits 1 if any count
+ * goes over it, so it can gate a build.
+ *
+ *   g++ -std=c++14 -pthread -O2 oop-code-alloc-bench.cpp -o alloc-bench
+ *   ./alloc-bench
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<long> heapAllocations(0);
+
+static void* countedAlloc(std::size_t size) {
+    heapAllocations++;
+    return std::malloc(size ? size : 1);
+}
+
+// Out of line so GCC cannot see free() paired with operator new, which it
+// reports as a (false) -Wmismatched-new-delete
+#ifdef __GNUC__
+__attribute__((noinline))
+#endif
+static void countedFree(void* p) noexcept { std::free(p); }
+
+// Every replaceable form, so new and delete always pair with malloc/free
+void* operator new(std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t size) {
+    if (void* p = countedAlloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAlloc(size); }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+
+// Reuse the system's classes; its demo main() is not run. The system is
+// one self-contained file with no header, so including it whole with
+// main() renamed is the only way in. If it is ever split into a header
+// and sources, include the header instead.
+#define main emergencySystemDemo
+#include "oop-code.cpp"
+#undef main
+
+static bool withinBounds = true;
+
+// Print an allocation count and flag it if it is over the bound
+static void report(const string& label, double used, double bound) {
+    cout << label << ": " << used << " (bound " << bound << ")";
+    if (used > bound) {
+        cout << "  ← OVER BOUND";
+        withinBounds = false;
+    }
+    cout << endl;
+}
+
+int main() {
+    Location emergencyLocation(40.7128, -74.0060, "Times Square, New York");
+
+    cout << "========== HEAP ALLOCATIONS PER ALERT ==========" << endl;
+    {
+        string smsUser = "bench_user";
+        string smsText = "EMERGENCY! I need help at Times Square!";
+        Location smsLocation = emergencyLocation;
+        vector<string> smsPhones = {"+1234567891", "+1234567893"};
+        long before = heapAllocations.load();
+        SMSAlert smsAlert(move(smsUser), move(smsText), move(smsLocation), move(smsPhones));
+        smsAlert.setOutput(nullptr); // Keep sendAlert output out of the count
+        smsAlert.sendAlert();
+        size_t readLength = smsAlert.getMessage().size() + smsAlert.getId().size() + smsAlert.getStatus().size();
+        long used = heapAllocations.load() - before;
+        
+        // Same text and location again: both are already interned
+        before = heapAllocations.load();
+        SMSAlert repeatAlert("bench_user", smsAlert.getSharedMessage(), smsAlert.getSharedLocation(),
+                             vector<string>{});
+        repeatAlert.setOutput(nullptr);
+        repeatAlert.sendAlert();
+        readLength += repeatAlert.getMessage().size() + repeatAlert.getId().size();
+        long repeatUsed = heapAllocations.load() - before;
+        
+        // The generated ID, plus for the new message and the new location:
+        // the shared value, its intern-pool entry and (first use only) the
+        // pool's bucket array
+        report("Build, send and read one SMS alert, new text", used, 7);
+        report("Same again, text and location already interned", repeatUsed, 1); // Only the ID
+        cout << "(read " << readLength << " chars)" << endl;
+    }
+
+    // Many few-recipient alerts sharing one interned notice
+    {
+        const vector<string> phones = {"+1234567891", "+1234567892", "+1234567893"};
+        const SharedText notice = "Evacuate now";
+        const SharedLocation noticeLocation = emergencyLocation;
+        long before = heapAllocations.load();
+        for (int i = 0; i < 100000; i++) {
+            SMSAlert bulkAlert("bench_user", notice, noticeLocation, {});
+            for (const auto& phone : phones) bulkAlert.addPhoneNumber(phone);
+        }
+        // Only the ID: three recipients fit the inline buffer
+        report("Bulk SMS alerts with 3 recipients, each", (heapAllocations.load() - before) / 100000.0, 1);
+    }
+
+    // Evacuation notices whose text arrives separately for every resident
+    {
+        vector<unique_ptr<Alert>> evacuation;
+        evacuation.reserve(10000);
+        long before = 0;
+        for (int i = 0; i < 10000; i++) {
+            if (i == 1) before = heapAllocations.load(); // The first alert interns the text and address
+            string text = "Building evacuation: leave by the nearest stairwell, do not use elevators.";
+            Location lobby(40.7580, -73.9855, "1 Times Square, Main Lobby");
+            evacuation.emplace_back(new PushNotificationAlert("resident" + to_string(i), move(text), move(lobby),
+                                                              {"token_" + to_string(i)}));
+        }
+        // The incoming text and address (freed once found interned), the
+        // token vector argument, the alert object and its ID
+        report("Evacuation push alerts, each", (heapAllocations.load() - before) / 9999.0, 5);
+    }
+    return withinBounds ? 0 : 1;
+}
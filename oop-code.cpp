@@ -17,6 +17,27 @@
 #include <ctime>
 #include <memory>
 #include <map>
+#include <sstream>
+#include <cstdint>
+#include <cstring>
+#include <chrono>
+#include <random>
+#include <queue>
+#include <deque>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <cstdlib>
+#include <new>
+#include <iomanip>
+#include <cctype>
+#include <future>
+#include <cmath>
 
 using namespace std;
 
@@ -31,12 +52,12 @@ private:
 public:
     // Constructor
     Location(double lat = 0.0, double lng = 0.0, string addr = "Unknown") 
-        : latitude(lat), longitude(lng), address(addr) {}
+        : latitude(lat), longitude(lng), address(move(addr)) {}
     
     // ENCAPSULATION: Getters (read-only access)
     double getLatitude() const { return latitude; }
     double getLongitude() const { return longitude; }
-    string getAddress() const { return address; }
+    const string& getAddress() const { return address; }
     
     // ENCAPSULATION: Setters (controlled write access)
     void setLatitude(double lat) { latitude = lat; }
@@ -44,10 +65,135 @@ public:
     void setAddress(const string& addr) { address = addr; }
     
     // Display location
-    void display() const {
-        cout << "Location: " << address << " (" << latitude << ", " << longitude << ")" << endl;
+    void display(ostream& out = cout) const {
+        out << "Location: " << address << " (" << latitude << ", " << longitude << ")" << endl;
+    }
+    
+    bool operator==(const Location& other) const {
+        return latitude == other.latitude && longitude == other.longitude && address == other.address;
+    }
+};
+
+struct LocationHash {
+    size_t operator()(const Location& loc) const {
+        size_t seed = hash<string>()(loc.getAddress());
+        seed ^= hash<double>()(loc.getLatitude()) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        seed ^= hash<double>()(loc.getLongitude()) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+        return seed;
+    }
+};
+
+// ==================== INTERNED VALUES ====================
+// A broadcast sends the same message and location to thousands of
+// alerts. Instead of each alert holding its own copy, equal values are
+// stored once (hash-consing) and alerts hold a reference-counted pointer
+// to the shared, immutable copy. The pool only keeps weak references, so
+// a value is freed once no alert uses it; expired entries are swept when
+// a shard has doubled in size since its last sweep.
+template <typename T, typename Hash = hash<T>>
+class InternPool {
+private:
+    static const size_t SHARDS = 16; // Separate locks so worker threads rarely contend
+    struct Shard {
+        mutex lock;
+        unordered_multimap<size_t, weak_ptr<const T>> entries; // Keyed by hash of the value
+        size_t sweepAt = 64;
+    };
+    Shard shards[SHARDS];
+
+    static void sweep(Shard& shard) {
+        for (auto it = shard.entries.begin(); it != shard.entries.end();) {
+            if (it->second.expired()) it = shard.entries.erase(it);
+            else ++it;
+        }
+        shard.sweepAt = max<size_t>(64, shard.entries.size() * 2);
+    }
+
+public:
+    // Copies (or moves) the value only if no equal value is live
+    template <typename V>
+    shared_ptr<const T> intern(V&& value) {
+        size_t key = Hash()(value);
+        Shard& shard = shards[(key >> 4) % SHARDS];
+        lock_guard<mutex> guard(shard.lock);
+        auto range = shard.entries.equal_range(key);
+        for (auto it = range.first; it != range.second; ++it) {
+            shared_ptr<const T> existing = it->second.lock();
+            if (existing && *existing == value) return existing;
+        }
+        if (shard.entries.size() >= shard.sweepAt) sweep(shard);
+        shared_ptr<const T> created = make_shared<const T>(forward<V>(value));
+        shard.entries.emplace(key, created);
+        return created;
     }
+    
+    // Distinct values currently in use
+    size_t liveCount() {
+        size_t count = 0;
+        for (auto& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            for (const auto& entry : shard.entries) count += !entry.second.expired();
+        }
+        return count;
+    }
+};
+
+// Handle to an interned value. Converts implicitly from a plain value,
+// so code that passes a string or Location keeps working unchanged.
+template <typename T, typename Hash = hash<T>>
+class Interned {
+private:
+    shared_ptr<const T> value;
+
+public:
+    Interned() : value(pool().intern(T())) {}
+    Interned(const T& v) : value(pool().intern(v)) {}
+    Interned(T&& v) : value(pool().intern(move(v))) {}
+    Interned(const char* text) : value(pool().intern(T(text))) {}
+    
+    const T& operator*() const { return *value; }
+    const T* operator->() const { return value.get(); }
+    long useCount() const { return value.use_count(); }
+    
+    static InternPool<T, Hash>& pool() {
+        static InternPool<T, Hash> instance;
+        return instance;
+    }
+};
+
+typedef Interned<string> SharedText;
+typedef Interned<Location, LocationHash> SharedLocation;
+
+// Stream that drops everything written to it. One per thread, so alerts
+// sent concurrently never share stream state.
+ostream& discardOutput() {
+    static thread_local ostream sink(nullptr);
+    return sink;
+}
+
+// ==================== CHANNELS ====================
+// Every way an alert can be delivered. The codes are also the channel
+// byte of the binary protocol, so existing values must not change.
+enum AlertChannel : uint8_t {
+    CHANNEL_UNKNOWN = 0, // Alert type with no channel code; never sent on the wire
+    CHANNEL_SMS, CHANNEL_EMAIL, CHANNEL_AUTHORITY, CHANNEL_PUSH, CHANNEL_VOICE
 };
+const int CHANNEL_COUNT = CHANNEL_VOICE + 1; // Keep at the last channel + 1
+
+AlertChannel channelForType(const string& type) {
+    if (type == "SMS") return CHANNEL_SMS;
+    if (type == "Email") return CHANNEL_EMAIL;
+    if (type == "Authority") return CHANNEL_AUTHORITY;
+    if (type == "Push") return CHANNEL_PUSH;
+    if (type == "Voice") return CHANNEL_VOICE;
+    cerr << "Error: Unknown alert type: " << type << endl;
+    return CHANNEL_UNKNOWN;
+}
+
+const char* channelName(AlertChannel channel) {
+    static const char* const names[CHANNEL_COUNT] = {"Unknown", "SMS", "Email", "Authority", "Push", "Voice"};
+    return channel < CHANNEL_COUNT ? names[channel] : "Unknown";
+}
 
 // ==================== ABSTRACTION EXAMPLE ====================
 // Abstract base class for Alert - defines interface without implementation
@@ -56,17 +202,26 @@ protected:
     string id;
     string userId;
     string type;
-    string message;
+    AlertChannel channel;
+    SharedText message;      // Shared with every alert carrying the same text
     string status;
     time_t timestamp;
-    Location location;
+    SharedLocation location;
+    ostream* output;         // Where sendAlert() reports; nullptr discards
+    static atomic<int> alertCount; // Keeps IDs unique within the same second, across threads
+    static atomic<int> sentCounts[CHANNEL_COUNT];
+
+    ostream& out() const { return output ? *output : discardOutput(); }
+    // Every channel's send path calls this once per delivered alert
+    void countSent() { sentCounts[channel]++; }
 
 public:
     // Constructor
-    Alert(string uid, string t, string msg, Location loc) 
-        : userId(uid), type(t), message(msg), status("pending"), location(loc) {
+    Alert(string uid, string t, SharedText msg, SharedLocation loc) 
+        : userId(move(uid)), type(move(t)), channel(channelForType(type)), message(move(msg)),
+          status("pending"), location(move(loc)), output(&cout) {
         timestamp = time(0);
-        id = to_string(timestamp) + "_" + uid;
+        id = to_string(timestamp) + "_" + userId + "_" + to_string(++alertCount);
     }
     
     // Virtual destructor for proper cleanup
@@ -83,79 +238,211 @@ public:
         cout << "\n=== Alert Summary ===" << endl;
         cout << "ID: " << id << endl;
         cout << "Type: " << type << endl;
-        cout << "Message: " << message << endl;
+        cout << "Message: " << *message << endl;
         cout << "Status: " << status << endl;
         cout << "Time: " << ctime(&timestamp);
-        location.display();
+        location->display();
     }
     
     // Getters
-    string getId() const { return id; }
-    string getType() const { return type; }
-    string getMessage() const { return message; }
-    string getStatus() const { return status; }
+    const string& getId() const { return id; }
+    const string& getUserId() const { return userId; }
+    const string& getType() const { return type; }
+    AlertChannel getChannel() const { return channel; }
+    const string& getMessage() const { return *message; }
+    const string& getStatus() const { return status; }
+    time_t getTimestamp() const { return timestamp; }
+    const Location& getLocation() const { return *location; }
+    const SharedText& getSharedMessage() const { return message; }
+    const SharedLocation& getSharedLocation() const { return location; }
     
     // Setters
     void setStatus(const string& s) { status = s; }
+    // Bulk runs pass nullptr so thousands of sends print nothing
+    void setOutput(ostream* stream) { output = stream; }
+    void setMessage(SharedText msg) { message = move(msg); }
+    void setLocation(SharedLocation loc) { location = move(loc); }
+    
+    // Alerts delivered through a channel, across all threads
+    static int sentCount(AlertChannel channel) { return sentCounts[channel].load(); }
 };
 
+atomic<int> Alert::alertCount(0);
+atomic<int> Alert::sentCounts[CHANNEL_COUNT];
+
 // ==================== INHERITANCE & POLYMORPHISM EXAMPLES ====================
 
-// INHERITANCE: SMSAlert inherits from Alert
-class SMSAlert : public Alert {
+// ==================== SMALL-BUFFER CONTAINERS ====================
+// Most alerts go to 1-5 recipients, so recipient lists keep their first
+// few items inside the alert object and only use the heap beyond that.
+
+// Fixed-capacity string stored inline (no heap), e.g. a phone number
+template <size_t N>
+class InlineString {
+private:
+    char chars[N + 1];
+    unsigned char length;
+
+public:
+    InlineString() : length(0) { chars[0] = '\0'; }
+    // Input longer than N is cut; use fits() to check first
+    InlineString(const string& text) : length((unsigned char)min(text.size(), N)) {
+        memcpy(chars, text.data(), length);
+        chars[length] = '\0';
+    }
+
+    static bool fits(const string& text) { return text.size() <= N; }
+
+    const char* c_str() const { return chars; }
+    size_t size() const { return length; }
+    string str() const { return string(chars, length); }
+};
+
+template <size_t N>
+ostream& operator<<(ostream& out, const InlineString<N>& text) {
+    return out << text.c_str();
+}
+
+// Vector with room for N items inside the object; moves everything to the
+// heap once it grows past N
+template <typename T, size_t N>
+class SmallVector {
 private:
-    vector<string> phoneNumbers;
+    T inlineItems[N];
+    vector<T> heapItems;
+    size_t count;
+
+    bool onHeap() const { return count > N; }
+
+public:
+    SmallVector() : count(0) {}
+
+    void push_back(T item) {
+        if (count < N) {
+            inlineItems[count++] = move(item);
+            return;
+        }
+        if (count == N) {
+            heapItems.reserve(2 * N);
+            for (auto& inlineItem : inlineItems) heapItems.push_back(move(inlineItem));
+        }
+        heapItems.push_back(move(item));
+        count++;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    T* begin() { return onHeap() ? heapItems.data() : inlineItems; }
+    T* end() { return begin() + count; }
+    const T* begin() const { return onHeap() ? heapItems.data() : inlineItems; }
+    const T* end() const { return begin() + count; }
+    T& operator[](size_t i) { return begin()[i]; }
+    const T& operator[](size_t i) const { return begin()[i]; }
+};
+
+// E.164 numbers: up to 15 digits plus the leading '+'
+typedef InlineString<16> PhoneNumber;
+
+// ==================== CHANNEL TEMPLATE ====================
+// Shared implementation for channels that send the same message to a list
+// of recipients. Each channel is a subclass that describes itself at
+// compile time (CRTP), so adding a channel needs no copied boilerplate:
+//   static const char* name()        e.g. "SMS Alert"
+//   static const char* action()      e.g. "Sending SMS"
+//   static const char* unit()        e.g. "contacts"
+//   static const char* sentStatus()  status after a successful send
+//   void render(const Recipient& recipient) const   prints one delivery
+// Recipients are stored in a SmallVector, so typical alerts need no
+// separate allocation for their recipient list.
+template <typename Channel, typename Recipient = string>
+class RecipientAlert : public Alert {
+protected:
+    static const size_t INLINE_RECIPIENTS = 4;
+    SmallVector<Recipient, INLINE_RECIPIENTS> recipients;
 
 public:
-    SMSAlert(string uid, string msg, Location loc, vector<string> phones)
-        : Alert(uid, "SMS", msg, loc), phoneNumbers(phones) {}
+    RecipientAlert(string uid, SharedText msg, SharedLocation loc, vector<string> to)
+        : Alert(move(uid), Channel::type(), move(msg), move(loc)) {
+        for (auto& recipient : to) recipients.push_back(Recipient(move(recipient)));
+    }
     
-    // POLYMORPHISM: Override sendAlert method
+    // POLYMORPHISM: One sendAlert for every recipient-list channel
     bool sendAlert() override {
-        cout << "\n[SMS Alert] Sending SMS to " << phoneNumbers.size() << " contacts..." << endl;
-        for (const auto& phone : phoneNumbers) {
-            cout << "  → Sending SMS to: " << phone << endl;
-            cout << "    Message: " << message << endl;
+        out() << "\n[" << Channel::name() << "] " << Channel::action() << " to "
+              << recipients.size() << " " << Channel::unit() << "..." << endl;
+        for (const auto& recipient : recipients) {
+            static_cast<const Channel*>(this)->render(recipient);
         }
-        status = "sent";
+        status = Channel::sentStatus();
+        countSent();
         return true;
     }
     
     // POLYMORPHISM: Override getAlertDetails
     string getAlertDetails() override {
-        return "SMS Alert sent to " + to_string(phoneNumbers.size()) + " contacts";
+        return string(Channel::name()) + " sent to " + to_string(recipients.size()) + " " + Channel::unit();
     }
     
-    void addPhoneNumber(const string& phone) {
-        phoneNumbers.push_back(phone);
-    }
+    void addRecipient(Recipient recipient) { recipients.push_back(move(recipient)); }
+    size_t recipientCount() const { return recipients.size(); }
 };
 
-// INHERITANCE: EmailAlert inherits from Alert
-class EmailAlert : public Alert {
+// INHERITANCE: SMSAlert inherits from Alert through RecipientAlert
+class SMSAlert : public RecipientAlert<SMSAlert, PhoneNumber> {
 private:
-    vector<string> emailAddresses;
-    string subject;
+    // Drop numbers too long to be valid instead of silently cutting them
+    static vector<string> validPhones(vector<string> phones) {
+        auto invalid = remove_if(phones.begin(), phones.end(), [](const string& phone) {
+            if (PhoneNumber::fits(phone)) return false;
+            cerr << "Error: Invalid phone number skipped: " << phone << endl;
+            return true;
+        });
+        phones.erase(invalid, phones.end());
+        return phones;
+    }
 
 public:
-    EmailAlert(string uid, string msg, Location loc, vector<string> emails)
-        : Alert(uid, "Email", msg, loc), emailAddresses(emails), subject("EMERGENCY ALERT") {}
+    static const char* type() { return "SMS"; }
+    static const char* name() { return "SMS Alert"; }
+    static const char* action() { return "Sending SMS"; }
+    static const char* unit() { return "contacts"; }
+    static const char* sentStatus() { return "sent"; }
     
-    // POLYMORPHISM: Override sendAlert method
-    bool sendAlert() override {
-        cout << "\n[Email Alert] Sending emails to " << emailAddresses.size() << " contacts..." << endl;
-        for (const auto& email : emailAddresses) {
-            cout << "  → Sending email to: " << email << endl;
-            cout << "    Subject: " << subject << endl;
-            cout << "    Body: " << message << endl;
-        }
-        status = "sent";
+    SMSAlert(string uid, SharedText msg, SharedLocation loc, vector<string> phones)
+        : RecipientAlert(move(uid), move(msg), move(loc), validPhones(move(phones))) {}
+    
+    void render(const PhoneNumber& phone) const {
+        out() << "  → Sending SMS to: " << phone << endl;
+        out() << "    Message: " << *message << endl;
+    }
+    
+    bool addPhoneNumber(const string& phone) {
+        if (!PhoneNumber::fits(phone)) return false;
+        addRecipient(PhoneNumber(phone));
         return true;
     }
+};
+
+// INHERITANCE: EmailAlert inherits from Alert through RecipientAlert
+class EmailAlert : public RecipientAlert<EmailAlert> {
+private:
+    string subject;
+
+public:
+    static const char* type() { return "Email"; }
+    static const char* name() { return "Email Alert"; }
+    static const char* action() { return "Sending emails"; }
+    static const char* unit() { return "recipients"; }
+    static const char* sentStatus() { return "sent"; }
     
-    // POLYMORPHISM: Override getAlertDetails
-    string getAlertDetails() override {
-        return "Email Alert sent to " + to_string(emailAddresses.size()) + " recipients";
+    EmailAlert(string uid, SharedText msg, SharedLocation loc, vector<string> emails)
+        : RecipientAlert(move(uid), move(msg), move(loc), move(emails)), subject("EMERGENCY ALERT") {}
+    
+    void render(const string& email) const {
+        out() << "  → Sending email to: " << email << endl;
+        out() << "    Subject: " << subject << endl;
+        out() << "    Body: " << *message << endl;
     }
     
     void setSubject(const string& subj) { subject = subj; }
@@ -169,23 +456,24 @@ private:
     int severity; // 1-5 scale
 
 public:
-    AuthorityAlert(string uid, string msg, Location loc, string authType)
-        : Alert(uid, "Authority", msg, loc), authorityType(authType), severity(5) {
+    AuthorityAlert(string uid, SharedText msg, SharedLocation loc, string authType)
+        : Alert(move(uid), "Authority", move(msg), move(loc)), authorityType(move(authType)), severity(5) {
         // Assign emergency numbers based on authority type
-        if (authType == "police") emergencyNumber = "911";
-        else if (authType == "fire") emergencyNumber = "911";
-        else if (authType == "medical") emergencyNumber = "911";
+        if (authorityType == "police") emergencyNumber = "911";
+        else if (authorityType == "fire") emergencyNumber = "911";
+        else if (authorityType == "medical") emergencyNumber = "911";
     }
     
     // POLYMORPHISM: Override sendAlert method
     bool sendAlert() override {
-        cout << "\n[Authority Alert] Contacting " << authorityType << " services..." << endl;
-        cout << "  → Emergency Number: " << emergencyNumber << endl;
-        cout << "  → Severity Level: " << severity << "/5" << endl;
-        cout << "  → Message: " << message << endl;
-        cout << "  → Dispatching emergency services to location..." << endl;
-        location.display();
+        out() << "\n[Authority Alert] Contacting " << authorityType << " services..." << endl;
+        out() << "  → Emergency Number: " << emergencyNumber << endl;
+        out() << "  → Severity Level: " << severity << "/5" << endl;
+        out() << "  → Message: " << *message << endl;
+        out() << "  → Dispatching emergency services to location..." << endl;
+        location->display(out());
         status = "dispatched";
+        countSent();
         return true;
     }
     
@@ -200,31 +488,25 @@ public:
     }
 };
 
-// INHERITANCE: PushNotificationAlert inherits from Alert
-class PushNotificationAlert : public Alert {
+// INHERITANCE: PushNotificationAlert inherits from Alert through RecipientAlert
+class PushNotificationAlert : public RecipientAlert<PushNotificationAlert> {
 private:
-    vector<string> deviceTokens;
     string notificationTitle;
 
 public:
-    PushNotificationAlert(string uid, string msg, Location loc, vector<string> tokens)
-        : Alert(uid, "Push", msg, loc), deviceTokens(tokens), notificationTitle("🚨 EMERGENCY") {}
+    static const char* type() { return "Push"; }
+    static const char* name() { return "Push Notification"; }
+    static const char* action() { return "Sending push notifications"; }
+    static const char* unit() { return "devices"; }
+    static const char* sentStatus() { return "delivered"; }
     
-    // POLYMORPHISM: Override sendAlert method
-    bool sendAlert() override {
-        cout << "\n[Push Notification] Sending push notifications to " << deviceTokens.size() << " devices..." << endl;
-        for (const auto& token : deviceTokens) {
-            cout << "  → Device Token: " << token.substr(0, 10) << "..." << endl;
-            cout << "    Title: " << notificationTitle << endl;
-            cout << "    Body: " << message << endl;
-        }
-        status = "delivered";
-        return true;
-    }
+    PushNotificationAlert(string uid, SharedText msg, SharedLocation loc, vector<string> tokens)
+        : RecipientAlert(move(uid), move(msg), move(loc), move(tokens)), notificationTitle("🚨 EMERGENCY") {}
     
-    // POLYMORPHISM: Override getAlertDetails
-    string getAlertDetails() override {
-        return "Push Notification sent to " + to_string(deviceTokens.size()) + " devices";
+    void render(const string& token) const {
+        out() << "  → Device Token: " << token.substr(0, 10) << "..." << endl;
+        out() << "    Title: " << notificationTitle << endl;
+        out() << "    Body: " << *message << endl;
     }
 };
 
@@ -234,7 +516,7 @@ private:
     string filename;
 
 public:
-    FileHandler(string fname) : filename(fname) {}
+    FileHandler(string fname) : filename(move(fname)) {}
     
     // FILE HANDLING: Write emergency log to file
     bool writeEmergencyLog(const Alert& alert) {
@@ -290,102 +572,3889 @@ public:
     }
 };
 
-// ==================== CLASS & OBJECT EXAMPLES ====================
+// ==================== REPLICATED LOG ====================
+// Writes every log entry to several replica files. An entry counts as
+// committed once a majority of replicas hold it, so losing one file (or
+// the disk it lives on) does not lose any emergency record.
+class ReplicatedLog {
+private:
+    vector<string> replicaFiles;
+    vector<bool> available;   // false = replica is down (fault injection)
+    vector<long> lastIndex;   // highest entry index stored on each replica
+    vector<bool> present;     // replica file exists on disk
+    long commitIndex;
+    int leader;
+    bool readOnly;            // too few replica files to tell what was committed
 
-// Contact class - represents an emergency contact
-class Contact {
+    // Entry format: index|alertId|type|status|message
+    static string formatEntry(long index, const Alert& alert) {
+        string message = alert.getMessage();
+        for (auto& c : message) {
+            if (c == '\n') c = ' ';
+        }
+        return to_string(index) + "|" + alert.getId() + "|" + alert.getType() + "|" +
+               alert.getStatus() + "|" + message;
+    }
+
+    static long entryIndex(const string& line) {
+        size_t bar = line.find('|');
+        if (bar == string::npos) return 0;
+        try {
+            return stol(line.substr(0, bar));
+        } catch (...) {
+            return 0;
+        }
+    }
+
+    vector<string> readEntries(int replica) const {
+        vector<string> entries;
+        ifstream inFile(replicaFiles[replica]);
+        string line;
+        while (getline(inFile, line)) {
+            if (entryIndex(line) > 0) entries.push_back(line);
+        }
+        return entries;
+    }
+
+    // Append a batch of entries to one replica with a single open/flush
+    bool writeBatch(int replica, const vector<string>& entries) {
+        if (!available[replica]) return false;
+        ofstream outFile(replicaFiles[replica], ios::app);
+        if (!outFile.is_open()) return false;
+        for (const auto& entry : entries) {
+            outFile << entry << '\n';
+        }
+        outFile.flush();
+        return outFile.good();
+    }
+
+    // Rewrite a replica keeping only its first `keep` entries. The new
+    // log goes to a temporary file that is renamed over the old one, so a
+    // crash part-way leaves the previous replica intact.
+    bool truncate(int replica, const vector<string>& entries, size_t keep) {
+        string temp = replicaFiles[replica] + ".tmp";
+        {
+            ofstream outFile(temp, ios::trunc);
+            if (!outFile.is_open()) return false;
+            for (size_t i = 0; i < keep && i < entries.size(); i++) {
+                outFile << entries[i] << '\n';
+            }
+            outFile.flush();
+            if (!outFile.good()) return false;
+        }
+        if (rename(temp.c_str(), replicaFiles[replica].c_str()) != 0) return false;
+        lastIndex[replica] = keep == 0 ? 0 : entryIndex(entries[keep - 1]);
+        return true;
+    }
+
+    // Drop every entry above `index` from a replica
+    bool truncateAfter(int replica, long index) {
+        vector<string> entries = readEntries(replica);
+        size_t keep = 0;
+        while (keep < entries.size() && entryIndex(entries[keep]) <= index) keep++;
+        if (keep == entries.size()) return true;
+        return truncate(replica, entries, keep);
+    }
+
+    int majority() const { return (int)replicaFiles.size() / 2 + 1; }
+
+    // Make a replica's log match the leader's committed log: entries that
+    // conflict with the leader are dropped, missed ones are copied.
+    // Sets how many entries were dropped and copied.
+    bool syncWithLeader(int replica, size_t& dropped, size_t& copied) {
+        vector<string> leaderEntries = readEntries(leader);
+        vector<string> ownEntries = readEntries(replica);
+        size_t agree = 0;
+        while (agree < ownEntries.size() && agree < leaderEntries.size() &&
+               ownEntries[agree] == leaderEntries[agree]) {
+            agree++;
+        }
+        dropped = ownEntries.size() - agree;
+        copied = 0;
+        if (dropped > 0 && !truncate(replica, ownEntries, agree)) {
+            cerr << "Error: Could not truncate replica " << replicaFiles[replica] << endl;
+            return false;
+        }
+        lastIndex[replica] = agree == 0 ? 0 : entryIndex(ownEntries[agree - 1]);
+        vector<string> missing(leaderEntries.begin() + agree, leaderEntries.end());
+        if (!writeBatch(replica, missing)) {
+            truncateAfter(replica, lastIndex[replica]); // Drop a partial copy
+            return false;
+        }
+        lastIndex[replica] = lastIndex[leader];
+        present[replica] = true;
+        copied = missing.size();
+        return true;
+    }
+
+    // Leave read-only mode once a majority of replica files exist again
+    void checkQuorum() {
+        if (!readOnly) return;
+        if ((int)count(present.begin(), present.end(), true) < majority()) return;
+        readOnly = false;
+        cout << "✓ Replica majority restored, log accepts writes again" << endl;
+    }
+
+public:
+    ReplicatedLog(vector<string> files)
+        : replicaFiles(move(files)), available(replicaFiles.size(), true),
+          lastIndex(replicaFiles.size(), 0), present(replicaFiles.size(), false),
+          commitIndex(0), leader(0), readOnly(false) {
+        // Recover state left by a previous run
+        for (size_t i = 0; i < replicaFiles.size(); i++) {
+            present[i] = ifstream(replicaFiles[i]).is_open();
+            vector<string> entries = readEntries((int)i);
+            if (!entries.empty()) lastIndex[i] = entryIndex(entries.back());
+        }
+        vector<long> held = lastIndex;
+        sort(held.begin(), held.end(), greater<long>());
+        electLeader();
+        
+        // Without a majority of files there is no telling which entries
+        // were committed, and the survivors may hold the only copy. Keep
+        // everything and refuse writes until the replicas are recovered.
+        int surviving = (int)count(present.begin(), present.end(), true);
+        if (surviving < majority() && held[0] > 0) {
+            readOnly = true;
+            commitIndex = held[0];
+            cerr << "Error: Only " << surviving << " of " << replicaFiles.size()
+                 << " log replicas found, starting read-only" << endl;
+            return;
+        }
+        
+        // Committed means held by a majority. Anything beyond that was
+        // never acknowledged (a crash mid-batch), so it is dropped.
+        commitIndex = held[majority() - 1];
+        for (size_t i = 0; i < replicaFiles.size(); i++) {
+            if (lastIndex[i] > commitIndex) truncateAfter((int)i, commitIndex);
+        }
+        electLeader();
+    }
+
+    // Append a batch of alerts. Returns true once a majority holds them.
+    bool appendBatch(const vector<shared_ptr<Alert>>& alerts) {
+        if (alerts.empty()) return true;
+        if (readOnly) {
+            cerr << "Error: Log is read-only until a majority of replicas is recovered" << endl;
+            return false;
+        }
+        
+        // New entries go after the committed log. A leader that missed a
+        // committed batch cannot serve it, so pick one that has it.
+        long base = commitIndex;
+        if ((!available[leader] || lastIndex[leader] < base) &&
+            (electLeader() < 0 || lastIndex[leader] < base)) {
+            cerr << "Error: No available replica holds the committed log" << endl;
+            return false;
+        }
+        
+        // Bring replicas that fell behind (a failed write, a restart) up
+        // to the committed log so they can take the new batch
+        for (size_t i = 0; i < replicaFiles.size(); i++) {
+            if (!available[i]) continue;
+            if (lastIndex[i] > base) truncateAfter((int)i, base);
+            size_t dropped, copied;
+            if (lastIndex[i] < base) syncWithLeader((int)i, dropped, copied);
+        }
+        
+        long next = base;
+        vector<string> entries;
+        for (const auto& alert : alerts) {
+            entries.push_back(formatEntry(++next, *alert));
+        }
+        
+        int acks = 0;
+        vector<int> attempted;
+        for (size_t i = 0; i < replicaFiles.size(); i++) {
+            // Only replicas that are caught up can take the new batch
+            if (lastIndex[i] != base || !available[i]) continue;
+            attempted.push_back((int)i);
+            if (writeBatch((int)i, entries)) {
+                lastIndex[i] = next;
+                present[i] = true;
+                acks++;
+            } else {
+                truncateAfter((int)i, base); // Drop a partial write
+            }
+        }
+        
+        if (acks < majority()) {
+            // Not committed: take the batch back off the replicas that
+            // stored it, so it can never be committed later and a retry
+            // does not store it twice
+            for (int replica : attempted) truncateAfter(replica, base);
+            cerr << "Error: Log batch reached only " << acks << " of "
+                 << replicaFiles.size() << " replicas" << endl;
+            return false;
+        }
+        commitIndex = next;
+        cout << "\n✓ Replicated " << entries.size() << " log entries to " << acks << "/"
+             << replicaFiles.size() << " replicas (commit index " << commitIndex << ")" << endl;
+        return true;
+    }
+
+    // Pick the available replica with the longest log as leader
+    int electLeader() {
+        int best = -1;
+        for (size_t i = 0; i < replicaFiles.size(); i++) {
+            if (!available[i]) continue;
+            if (best < 0 || lastIndex[i] > lastIndex[best]) best = (int)i;
+        }
+        if (best >= 0) leader = best;
+        return best;
+    }
+
+    void failReplica(int replica) {
+        available[replica] = false;
+        cout << "✗ Replica down: " << replicaFiles[replica] << endl;
+        if (replica == leader && electLeader() >= 0) {
+            cout << "  → New leader: " << replicaFiles[leader] << endl;
+        }
+    }
+
+    // Bring a replica back and make its log match the leader's
+    void recoverReplica(int replica) {
+        available[replica] = true;
+        if (replica == leader) return;
+        size_t dropped, copied;
+        if (!syncWithLeader(replica, dropped, copied)) return;
+        cout << "✓ Replica recovered: " << replicaFiles[replica] << " (dropped " << dropped
+             << " conflicting, caught up " << copied << " entries)" << endl;
+        checkQuorum();
+    }
+
+    // Committed entries with an index above `after`, oldest first
+    vector<string> entriesAfter(long after) const {
+        vector<string> tail;
+        for (const auto& entry : readEntries(leader)) {
+            long index = entryIndex(entry);
+            if (index > after && index <= commitIndex) tail.push_back(entry);
+        }
+        return tail;
+    }
+
+    // Split an entry into its index, alert ID and status
+    static bool parseEntry(const string& entry, long& index, string& alertId, string& status) {
+        size_t idEnd = entry.find('|');
+        size_t typeEnd = entry.find('|', idEnd + 1);
+        size_t statusStart = entry.find('|', typeEnd + 1);
+        size_t statusEnd = entry.find('|', statusStart + 1);
+        if (statusEnd == string::npos) return false;
+        index = entryIndex(entry);
+        alertId = entry.substr(idEnd + 1, typeEnd - idEnd - 1);
+        status = entry.substr(statusStart + 1, statusEnd - statusStart - 1);
+        return index > 0;
+    }
+
+    long getCommitIndex() const { return commitIndex; }
+    const string& getLeaderFile() const { return replicaFiles[leader]; }
+};
+
+// ==================== CONCURRENCY CORE ====================
+// Bounded multi-producer/multi-consumer ring queue (Vyukov's design).
+// Each cell carries a sequence number that tells producers and consumers
+// whose turn it is, so push and pop need one CAS and no locks.
+template <typename T>
+class BoundedMPMCQueue {
 private:
-    string id;
-    string name;
-    string phone;
-    string email;
-    string relation;
-    string address;
+    struct Cell {
+        atomic<size_t> sequence;
+        T data;
+    };
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    char pad0[64]; // Keep the two cursors on separate cache lines
+    atomic<size_t> enqueuePos;
+    char pad1[64];
+    atomic<size_t> dequeuePos;
+    char pad2[64];
 
 public:
-    Contact(string n, string p, string e, string r, string addr)
-        : name(n), phone(p), email(e), relation(r), address(addr) {
-        id = to_string(time(0)) + "_" + n;
+    // Capacity is rounded up to a power of two
+    explicit BoundedMPMCQueue(size_t capacity) : enqueuePos(0), dequeuePos(0) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        cells.reset(new Cell[size]);
+        mask = size - 1;
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, memory_order_relaxed);
+        }
     }
-    
-    // Getters
-    string getId() const { return id; }
-    string getName() const { return name; }
-    string getPhone() const { return phone; }
-    string getEmail() const { return email; }
-    string getRelation() const { return relation; }
-    string getAddress() const { return address; }
-    
-    void display() const {
-        cout << "\n--- Contact Info ---" << endl;
-        cout << "Name: " << name << endl;
-        cout << "Phone: " << phone << endl;
-        cout << "Email: " << email << endl;
-        cout << "Relation: " << relation << endl;
-        cout << "Address: " << address << endl;
+
+    BoundedMPMCQueue(const BoundedMPMCQueue&) = delete;
+    BoundedMPMCQueue& operator=(const BoundedMPMCQueue&) = delete;
+
+    // Returns false when the queue is full
+    bool tryPush(T value) {
+        size_t pos = enqueuePos.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    cell.data = move(value);
+                    cell.sequence.store(pos + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    // Returns false when the queue is empty
+    bool tryPop(T& value) {
+        size_t pos = dequeuePos.load(memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t seq = cell.sequence.load(memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, memory_order_relaxed)) {
+                    value = move(cell.data);
+                    cell.sequence.store(pos + mask + 1, memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(memory_order_relaxed);
+            }
+        }
     }
+
+    size_t capacity() const { return mask + 1; }
 };
 
-// User class - represents a system user
-class User {
+// Fixed set of worker threads fed by a BoundedMPMCQueue. Idle workers spin
+// briefly (lowest latency), then yield, then park on a condition variable
+// until submit() signals, so an idle pool costs no CPU and no wakeups.
+class WorkerPool {
 private:
-    string userId;
-    string name;
-    string email;
-    string phone;
-    string password; // In real system, this would be hashed
-    vector<Contact> contacts;
+    BoundedMPMCQueue<function<void()>> tasks;
+    vector<thread> workers;
+    atomic<bool> stopping;
+    atomic<int> parked;
+    atomic<long> unfinished;
+    mutex parkMutex;
+    condition_variable parkSignal;
+    mutex idleMutex;
+    condition_variable idleSignal; // unfinished reached zero
+
+    static const int SPIN_LIMIT = 64;
+    static const int YIELD_LIMIT = 80;
+
+    void finishOne() {
+        if (--unfinished == 0) {
+            lock_guard<mutex> lock(idleMutex);
+            idleSignal.notify_all();
+        }
+    }
+
+    void workerLoop() {
+        function<void()> task;
+        int idle = 0;
+        while (true) {
+            if (tasks.tryPop(task)) {
+                task();
+                task = nullptr;
+                finishOne();
+                idle = 0;
+                continue;
+            }
+            if (stopping.load()) return;
+            if (++idle < SPIN_LIMIT) continue;
+            if (idle < YIELD_LIMIT) {
+                this_thread::yield();
+                continue;
+            }
+            // Park. Announce it, then look once more: a submit() that ran
+            // before the announcement is seen here, and one that runs after
+            // it sees parked > 0 and signals (the fences pair with submit's).
+            unique_lock<mutex> lock(parkMutex);
+            parked++;
+            atomic_thread_fence(memory_order_seq_cst);
+            bool found = tasks.tryPop(task);
+            if (!found && !stopping.load()) parkSignal.wait(lock);
+            parked--;
+            lock.unlock();
+            if (found) {
+                task();
+                task = nullptr;
+                finishOne();
+            }
+            idle = 0;
+        }
+    }
 
 public:
-    User(string n, string e, string p, string pass)
-        : name(n), email(e), phone(p), password(pass) {
-        userId = to_string(time(0)) + "_user";
+    WorkerPool(size_t threads, size_t queueCapacity = 1024)
+        : tasks(queueCapacity), stopping(false), parked(0), unfinished(0) {
+        for (size_t i = 0; i < threads; i++) {
+            workers.emplace_back(&WorkerPool::workerLoop, this);
+        }
     }
-    
-    // Add contact
-    void addContact(const Contact& contact) {
-        contacts.push_back(contact);
-        cout << "✓ Contact added: " << contact.getName() << endl;
+
+    // Finishes queued work, then joins the workers
+    ~WorkerPool() {
+        waitIdle();
+        {
+            lock_guard<mutex> lock(parkMutex); // A worker about to park sees it
+            stopping = true;
+        }
+        parkSignal.notify_all();
+        for (auto& worker : workers) worker.join();
     }
-    
-    // Get all contacts
-    vector<Contact> getContacts() const { return contacts; }
-    
-    // Getters
-    string getUserId() const { return userId; }
-    string getName() const { return name; }
-    string getEmail() const { return email; }
-    string getPhone() const { return phone; }
-    
-    void displayProfile() const {
-        cout << "\n========== USER PROFILE ==========" << endl;
-        cout << "User ID: " << userId << endl;
-        cout << "Name: " << name << endl;
-        cout << "Email: " << email << endl;
-        cout << "Phone: " << phone << endl;
-        cout << "Total Contacts: " << contacts.size() << endl;
-        cout << "==================================" << endl;
+
+    // Returns false when the queue is full so callers can apply backpressure
+    bool submit(function<void()> task) {
+        unfinished++;
+        if (!tasks.tryPush(move(task))) {
+            finishOne();
+            return false;
+        }
+        atomic_thread_fence(memory_order_seq_cst);
+        if (parked.load() > 0) {
+            lock_guard<mutex> lock(parkMutex); // Wait until the parking worker is asleep
+            parkSignal.notify_one();
+        }
+        return true;
     }
+
+    // Block until every submitted task has run
+    void waitIdle() {
+        unique_lock<mutex> lock(idleMutex);
+        idleSignal.wait(lock, [this]() { return unfinished.load() == 0; });
+    }
+
+    size_t size() const { return workers.size(); }
 };
 
-// ==================== DEMONSTRATION OF POLYMORPHISM ====================
-void demonstratePolymorphism(vector<shared_ptr<Alert>>& alerts) {
-    cout << "\n\n========== DEMONSTRATING POLYMORPHISM ==========" << endl;
-    cout << "Sending different types of alerts using same interface..." << endl;
-    
-    // POLYMORPHISM: Calling the same method on different object types
-    for (auto& alert : alerts) {
-        alert->sendAlert(); // Different behavior based on actual object type
-        cout << alert->getAlertDetails() << endl;
+// ==================== CREDENTIALS ====================
+// SHA-256 (FIPS 180-4), used for password hashing and token signing
+class SHA256 {
+private:
+    uint32_t state[8];
+    uint64_t totalBytes;
+    unsigned char block[64];
+    size_t blockLength;
+
+    static uint32_t rotr(uint32_t x, int n) { return (x >> n) | (x << (32 - n)); }
+
+    void transform(const unsigned char* chunk) {
+        static const uint32_t k[64] = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+        };
+        uint32_t w[64];
+        for (int i = 0; i < 16; i++) {
+            w[i] = (uint32_t)chunk[4 * i] << 24 | (uint32_t)chunk[4 * i + 1] << 16 |
+                   (uint32_t)chunk[4 * i + 2] << 8 | (uint32_t)chunk[4 * i + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + k[i] + w[i];
+            uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g; g = f; f = e; e = d + t1;
+            d = c; c = b; b = a; a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
     }
-}
 
-// ==================== MAIN FUNCTION ====================
-int main() {
-    cout << "╔════════════════════════════════════════════════════════╗" << endl;
-    cout << "║   EMERGENCY CONTACT SYSTEM - OOP IMPLEMENTATION        ║" << endl;
-    cout << "║   Demonstrating: Classes, Encapsulation, Abstraction,  ║" << endl;
-    cout << "║   Inheritance, Polymorphism, and File Handling         ║" << endl;
+public:
+    SHA256() { reset(); }
+
+    void reset() {
+        static const uint32_t initial[8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        memcpy(state, initial, sizeof(state));
+        totalBytes = 0;
+        blockLength = 0;
+    }
+
+    void update(const void* data, size_t length) {
+        const unsigned char* bytes = (const unsigned char*)data;
+        totalBytes += length;
+        while (length > 0) {
+            size_t take = min(length, 64 - blockLength);
+            memcpy(block + blockLength, bytes, take);
+            blockLength += take;
+            bytes += take;
+            length -= take;
+            if (blockLength == 64) {
+                transform(block);
+                blockLength = 0;
+            }
+        }
+    }
+
+    // Writes the 32-byte digest; the object must be reset() before reuse
+    void finish(unsigned char digest[32]) {
+        uint64_t bits = totalBytes * 8;
+        unsigned char padding = 0x80;
+        update(&padding, 1);
+        padding = 0;
+        while (blockLength != 56) update(&padding, 1);
+        unsigned char length[8];
+        for (int i = 0; i < 8; i++) length[i] = (unsigned char)(bits >> (56 - 8 * i));
+        update(length, 8);
+        for (int i = 0; i < 8; i++) {
+            for (int j = 0; j < 4; j++) digest[4 * i + j] = (unsigned char)(state[i] >> (24 - 8 * j));
+        }
+    }
+
+    // Digest of data as 32 raw bytes
+    static string hash(const string& data) {
+        SHA256 sha;
+        unsigned char digest[32];
+        sha.update(data.data(), data.size());
+        sha.finish(digest);
+        return string((const char*)digest, 32);
+    }
+};
+
+// HMAC-SHA256 (RFC 2104) as 32 raw bytes
+string hmacSHA256(const string& key, const string& message) {
+    string keyBlock = key.size() > 64 ? SHA256::hash(key) : key;
+    keyBlock.resize(64, '\0');
+    string inner(64, '\0'), outer(64, '\0');
+    for (int i = 0; i < 64; i++) {
+        inner[i] = (char)(keyBlock[i] ^ 0x36);
+        outer[i] = (char)(keyBlock[i] ^ 0x5c);
+    }
+    return SHA256::hash(outer + SHA256::hash(inner + message));
+}
+
+string toHex(const string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char b : bytes) {
+        hex += digits[b >> 4];
+        hex += digits[b & 15];
+    }
+    return hex;
+}
+
+// Returns false if hex is not valid hexadecimal
+bool fromHex(const string& hex, string& bytes) {
+    if (hex.size() % 2 != 0) return false;
+    bytes.clear();
+    for (size_t i = 0; i < hex.size(); i += 2) {
+        int value = 0;
+        for (size_t j = i; j < i + 2; j++) {
+            char c = hex[j];
+            value <<= 4;
+            if (c >= '0' && c <= '9') value |= c - '0';
+            else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+            else return false;
+        }
+        bytes += (char)value;
+    }
+    return true;
+}
+
+// Compares in time that depends only on the length, not on where the
+// first difference is, so timing does not leak how much of a guess matched
+bool constantTimeEquals(const string& a, const string& b) {
+    if (a.size() != b.size()) return false;
+    unsigned char diff = 0;
+    for (size_t i = 0; i < a.size(); i++) diff |= (unsigned char)(a[i] ^ b[i]);
+    return diff == 0;
+}
+
+// Memory-hard password hashing. Follows scrypt's ROMix structure: fill a
+// table of 2^cost blocks sequentially, then read it back in a
+// data-dependent order, so every guess needs the whole table in memory.
+// The mixing function is SHA-256, so hashes are not interchangeable with
+// standard scrypt. Stored format: cost$salt-hex$hash-hex
+class PasswordHasher {
+private:
+    static atomic<int> defaultCost; // Read by hash() on any thread
+
+    static string romix(const string& password, const string& salt, int cost) {
+        const size_t blocks = (size_t)1 << cost;
+        vector<unsigned char> table(blocks * 32); // One contiguous allocation
+        unsigned char x[32];
+        memcpy(x, hmacSHA256(salt, password).data(), 32);
+        SHA256 sha;
+        for (size_t i = 0; i < blocks; i++) {
+            memcpy(&table[i * 32], x, 32);
+            sha.reset();
+            sha.update(x, 32);
+            sha.finish(x);
+        }
+        for (size_t i = 0; i < blocks; i++) {
+            uint32_t j = ((uint32_t)x[0] | (uint32_t)x[1] << 8 | (uint32_t)x[2] << 16 |
+                          (uint32_t)x[3] << 24) & (blocks - 1);
+            for (size_t k = 0; k < 32; k++) x[k] ^= table[j * 32 + k];
+            sha.reset();
+            sha.update(x, 32);
+            sha.finish(x);
+        }
+        return hmacSHA256(password, string((const char*)x, 32));
+    }
+
+    static string randomSalt() {
+        random_device device;
+        string salt(16, '\0');
+        for (auto& c : salt) c = (char)(device() & 0xFF);
+        return salt;
+    }
+
+public:
+    static const int MIN_COST = 4;
+    static const int MAX_COST = 24;
+
+    // Per-deployment cost: memory is 32 * 2^cost bytes per hash
+    static void setDefaultCost(int cost) {
+        defaultCost = max((int)MIN_COST, min((int)MAX_COST, cost));
+    }
+    static int getDefaultCost() { return defaultCost.load(); }
+
+    static string hash(const string& password) { return hash(password, defaultCost.load()); }
+
+    static string hash(const string& password, int cost) {
+        cost = max((int)MIN_COST, min((int)MAX_COST, cost));
+        string salt = randomSalt();
+        return to_string(cost) + "$" + toHex(salt) + "$" + toHex(romix(password, salt, cost));
+    }
+
+    static bool verify(const string& password, const string& stored) {
+        size_t first = stored.find('$');
+        size_t second = stored.find('$', first + 1);
+        if (first == string::npos || second == string::npos) return false;
+        int cost;
+        try {
+            cost = stoi(stored.substr(0, first));
+        } catch (...) {
+            return false;
+        }
+        string salt, expected;
+        if (cost < MIN_COST || cost > MAX_COST) return false;
+        if (!fromHex(stored.substr(first + 1, second - first - 1), salt)) return false;
+        if (!fromHex(stored.substr(second + 1), expected)) return false;
+        return constantTimeEquals(romix(password, salt, cost), expected);
+    }
+};
+
+atomic<int> PasswordHasher::defaultCost(14);
+
+// Runs password checks on its own small worker pool. When the pool's queue
+// is full, new checks are refused instead of queued, so a login burst
+// cannot take CPU away from alert dispatch.
+class CredentialService {
+private:
+    WorkerPool workers;
+
+public:
+    CredentialService(size_t threads = 2, size_t maxQueued = 64) : workers(threads, maxQueued) {}
+
+    // Returns false if the service is saturated; the caller should retry later
+    bool verifyAsync(string password, string storedHash, function<void(bool)> done) {
+        auto check = [password, storedHash, done]() {
+            done(PasswordHasher::verify(password, storedHash));
+        };
+        return workers.submit(check);
+    }
+
+    void waitIdle() { workers.waitIdle(); }
+};
+
+// Signed session tokens ("userId.expiry.signature") for alert triggers.
+// Verified tokens are cached, so repeated triggers from one session cost
+// a SHA-256 and a hash-map lookup instead of an HMAC. The cache is keyed
+// by the token's digest: 32 bytes whatever the token length, and no live
+// credential is kept in memory. The cache is split into shards, each
+// with its own lock, so concurrent triggers rarely contend.
+class SessionTokenVerifier {
+private:
+    struct TokenDigest {
+        unsigned char bytes[32];
+
+        explicit TokenDigest(const string& token) {
+            SHA256 sha;
+            sha.update(token.data(), token.size());
+            sha.finish(bytes);
+        }
+        bool operator==(const TokenDigest& other) const { return memcmp(bytes, other.bytes, 32) == 0; }
+    };
+    struct DigestHash {
+        // The digest is already uniformly distributed; use its first bytes
+        size_t operator()(const TokenDigest& digest) const {
+            size_t value;
+            memcpy(&value, digest.bytes, sizeof(value));
+            return value;
+        }
+    };
+    struct CachedToken {
+        string userId;
+        time_t validUntil;
+    };
+    struct Shard {
+        mutex lock;
+        unordered_map<TokenDigest, CachedToken, DigestHash> verified; // token -> owner
+        unordered_map<TokenDigest, time_t, DigestHash> revoked;       // token -> its expiry
+    };
+    static const size_t SHARDS = 16;
+
+    string secret;
+    int cacheSeconds;
+    Shard shards[SHARDS];
+    atomic<long> hits;
+    atomic<long> misses;
+
+    // Uses the last digest byte, independent of the bytes DigestHash uses
+    Shard& shardFor(const TokenDigest& digest) { return shards[digest.bytes[31] % SHARDS]; }
+
+    string sign(const string& payload) const { return toHex(hmacSHA256(secret, payload)); }
+
+    // Full check: signature and expiry. Sets userId and expiry on success.
+    bool verifySignature(const string& token, time_t now, string& userId, time_t& expiry) const {
+        size_t sigDot = token.rfind('.');
+        if (sigDot == string::npos || sigDot == 0) return false;
+        size_t expiryDot = token.rfind('.', sigDot - 1);
+        if (expiryDot == string::npos) return false;
+        
+        string payload = token.substr(0, sigDot);
+        if (!constantTimeEquals(sign(payload), token.substr(sigDot + 1))) return false;
+        try {
+            expiry = (time_t)stoll(token.substr(expiryDot + 1, sigDot - expiryDot - 1));
+        } catch (...) {
+            return false;
+        }
+        if (expiry <= now) return false;
+        userId = token.substr(0, expiryDot);
+        return true;
+    }
+
+public:
+    SessionTokenVerifier(string key, int cacheTtlSeconds = 300)
+        : secret(move(key)), cacheSeconds(cacheTtlSeconds), hits(0), misses(0) {}
+
+    string issue(const string& userId, time_t now, int lifetimeSeconds) const {
+        string payload = userId + "." + to_string((long long)(now + lifetimeSeconds));
+        return payload + "." + sign(payload);
+    }
+
+    // Returns true and sets userId if the token is valid and not revoked
+    bool verify(const string& token, time_t now, string& userId) {
+        TokenDigest digest(token);
+        Shard& shard = shardFor(digest);
+        {
+            lock_guard<mutex> guard(shard.lock);
+            auto cached = shard.verified.find(digest);
+            if (cached != shard.verified.end()) {
+                if (cached->second.validUntil > now) {
+                    hits++;
+                    userId = cached->second.userId;
+                    return true;
+                }
+                shard.verified.erase(cached);
+            }
+            if (shard.revoked.count(digest)) return false;
+        }
+        
+        // Cache miss: check the signature outside the lock
+        misses++;
+        time_t expiry;
+        if (!verifySignature(token, now, userId, expiry)) return false;
+        
+        lock_guard<mutex> guard(shard.lock);
+        if (shard.revoked.count(digest)) return false; // Revoked meanwhile
+        shard.verified[digest] = CachedToken{userId, min(expiry, now + cacheSeconds)};
+        return true;
+    }
+
+    // Reject the token from now on, even if it is cached
+    void revoke(const string& token, time_t now) {
+        string userId;
+        time_t expiry;
+        if (!verifySignature(token, now, userId, expiry)) return; // Already unusable
+        TokenDigest digest(token);
+        Shard& shard = shardFor(digest);
+        lock_guard<mutex> guard(shard.lock);
+        shard.verified.erase(digest);
+        shard.revoked[digest] = expiry;
+    }
+
+    // Drop cache entries and revocations that have expired
+    void purgeExpired(time_t now) {
+        for (auto& shard : shards) {
+            lock_guard<mutex> guard(shard.lock);
+            for (auto it = shard.verified.begin(); it != shard.verified.end();) {
+                it = it->second.validUntil <= now ? shard.verified.erase(it) : next(it);
+            }
+            for (auto it = shard.revoked.begin(); it != shard.revoked.end();) {
+                it = it->second <= now ? shard.revoked.erase(it) : next(it);
+            }
+        }
+    }
+
+    long cacheHits() const { return hits.load(); }
+    long cacheMisses() const { return misses.load(); }
+};
+
+// ==================== CLASS & OBJECT EXAMPLES ====================
+
+// Contact class - represents an emergency contact
+class Contact {
+private:
+    string id;
+    string name;
+    string phone;
+    string email;
+    string relation;
+    string address;
+    int priority; // Higher is notified first (matches contacts.priority)
+
+public:
+    Contact(string n, string p, string e, string r, string addr, int prio = 1)
+        : name(move(n)), phone(move(p)), email(move(e)), relation(move(r)), address(move(addr)), priority(prio) {
+        id = to_string(time(0)) + "_" + name;
+    }
+    
+    // Rebuild a contact from saved state, keeping its original ID
+    static Contact restore(string savedId, string n, string p, string e, string r, string addr, int prio) {
+        Contact contact(move(n), move(p), move(e), move(r), move(addr), prio);
+        contact.id = move(savedId);
+        return contact;
+    }
+    
+    // Getters
+    const string& getId() const { return id; }
+    const string& getName() const { return name; }
+    const string& getPhone() const { return phone; }
+    const string& getEmail() const { return email; }
+    const string& getRelation() const { return relation; }
+    const string& getAddress() const { return address; }
+    int getPriority() const { return priority; }
+    
+    void setPriority(int prio) { priority = prio; }
+    
+    void display() const {
+        cout << "\n--- Contact Info ---" << endl;
+        cout << "Name: " << name << endl;
+        cout << "Phone: " << phone << endl;
+        cout << "Email: " << email << endl;
+        cout << "Relation: " << relation << endl;
+        cout << "Address: " << address << endl;
+        cout << "Priority: " << priority << endl;
+    }
+};
+
+// User class - represents a system user
+class User {
+private:
+    string userId;
+    string name;
+    string email;
+    string phone;
+    string passwordHash; // PasswordHasher format, never the plain password
+    vector<Contact> contacts;
+    static int userCount; // Keeps IDs unique within the same second
+
+    struct Restored {};
+    User(Restored, string id, string n, string e, string p, string hash, vector<Contact> saved)
+        : userId(move(id)), name(move(n)), email(move(e)), phone(move(p)),
+          passwordHash(move(hash)), contacts(move(saved)) {}
+
+public:
+    User(string n, string e, string p, string pass)
+        : name(move(n)), email(move(e)), phone(move(p)), passwordHash(PasswordHasher::hash(pass)) {
+        userId = to_string(time(0)) + "_user" + to_string(++userCount);
+    }
+    
+    // Rebuild a user from saved state (no re-hashing, no new ID)
+    static User restore(string id, string n, string e, string p, string hash, vector<Contact> saved) {
+        return User(Restored(), move(id), move(n), move(e), move(p), move(hash), move(saved));
+    }
+    
+    // Add contact
+    void addContact(Contact contact) {
+        contacts.push_back(move(contact));
+        cout << "✓ Contact added: " << contacts.back().getName() << endl;
+    }
+    
+    // Get all contacts
+    const vector<Contact>& getContacts() const { return contacts; }
+    
+    // Contacts in notification order: highest priority first, ties keep
+    // the order they were added in
+    vector<Contact> getContactsByPriority() const {
+        vector<Contact> ordered = contacts;
+        stable_sort(ordered.begin(), ordered.end(), [](const Contact& a, const Contact& b) {
+            return a.getPriority() > b.getPriority();
+        });
+        return ordered;
+    }
+    
+    // Getters
+    const string& getUserId() const { return userId; }
+    const string& getName() const { return name; }
+    const string& getEmail() const { return email; }
+    const string& getPhone() const { return phone; }
+    const string& getPasswordHash() const { return passwordHash; }
+    
+    bool checkPassword(const string& attempt) const {
+        return PasswordHasher::verify(attempt, passwordHash);
+    }
+    
+    void displayProfile() const {
+        cout << "\n========== USER PROFILE ==========" << endl;
+        cout << "User ID: " << userId << endl;
+        cout << "Name: " << name << endl;
+        cout << "Email: " << email << endl;
+        cout << "Phone: " << phone << endl;
+        cout << "Total Contacts: " << contacts.size() << endl;
+        cout << "==================================" << endl;
+    }
+};
+
+int User::userCount = 0;
+
+// ==================== VOICE CALL CHANNEL ====================
+enum CallOutcome { CALL_ANSWERED, CALL_NO_ANSWER, CALL_BUSY };
+
+// Simulated telephony gateway. Each trunk has a fixed number of call
+// slots; ringing uses a seeded random model of answer and timeout times
+// so escalation behaviour can be load-tested repeatably.
+class TelephonyGateway {
+private:
+    struct Trunk {
+        string name;
+        int slots;
+        int active;
+    };
+    vector<Trunk> trunks;
+    mt19937 rng;
+    double answerRate;        // Chance a call is picked up
+    double busyRate;          // Chance the line is busy
+    double meanAnswerSeconds; // Mean ring time before pickup
+    double ringTimeout;       // Give up after this many seconds
+
+public:
+    TelephonyGateway(unsigned seed = 42, double answer = 0.6, double busy = 0.1,
+                     double meanAnswer = 12.0, double timeout = 30.0)
+        : rng(seed), answerRate(answer), busyRate(busy),
+          meanAnswerSeconds(meanAnswer), ringTimeout(timeout) {}
+
+    void addTrunk(const string& name, int slots) {
+        trunks.push_back({name, slots, 0});
+    }
+
+    // Reserve a slot on the least-loaded trunk; -1 if every slot is in use
+    int openCall() {
+        int best = -1;
+        for (size_t i = 0; i < trunks.size(); i++) {
+            if (trunks[i].active >= trunks[i].slots) continue;
+            if (best < 0 || trunks[i].active < trunks[best].active) best = (int)i;
+        }
+        if (best >= 0) trunks[best].active++;
+        return best;
+    }
+
+    void closeCall(int trunk) {
+        if (trunk >= 0 && trunks[trunk].active > 0) trunks[trunk].active--;
+    }
+
+    // Ring a number; seconds is set to how long the call attempt took
+    CallOutcome ring(const string& phone, double& seconds) {
+        (void)phone; // The simulator treats every number alike
+        uniform_real_distribution<double> chance(0.0, 1.0);
+        double roll = chance(rng);
+        if (roll < busyRate) {
+            seconds = 2.0;
+            return CALL_BUSY;
+        }
+        if (roll < busyRate + answerRate) {
+            exponential_distribution<double> pickup(1.0 / meanAnswerSeconds);
+            seconds = 2.0 + pickup(rng);
+            if (seconds <= ringTimeout) return CALL_ANSWERED;
+        }
+        seconds = ringTimeout;
+        return CALL_NO_ANSWER;
+    }
+
+    int activeCalls() const {
+        int total = 0;
+        for (const auto& trunk : trunks) total += trunk.active;
+        return total;
+    }
+
+    int totalSlots() const {
+        int total = 0;
+        for (const auto& trunk : trunks) total += trunk.slots;
+        return total;
+    }
+};
+
+// INHERITANCE: VoiceCallAlert calls contacts one at a time, in order,
+// until someone answers. A call holds a gateway slot from placeCall()
+// until finishCall(); sendAlert() runs the calls back to back, while a
+// scheduler (see simulateCallLoad) can keep many alerts' calls in flight.
+// The call list is shared, so many alerts can ring the same contacts
+// without each holding a copy.
+class VoiceCallAlert : public Alert {
+private:
+    shared_ptr<const vector<Contact>> contacts;
+    TelephonyGateway& gateway;
+    string answeredBy;
+    int callsMade;
+    double elapsedSeconds;
+    size_t nextContact;       // Next contact to call, in order
+    int activeTrunk;          // Slot held by the call in progress, -1 if none
+    CallOutcome lastOutcome;
+    double lastSeconds;
+
+public:
+    VoiceCallAlert(string uid, SharedText msg, SharedLocation loc, shared_ptr<const vector<Contact>> callOrder,
+                   TelephonyGateway& gw)
+        : Alert(move(uid), "Voice", move(msg), move(loc)), contacts(move(callOrder)), gateway(gw),
+          callsMade(0), elapsedSeconds(0.0), nextContact(0), activeTrunk(-1),
+          lastOutcome(CALL_NO_ANSWER), lastSeconds(0.0) {}
+    
+    VoiceCallAlert(string uid, SharedText msg, SharedLocation loc, vector<Contact> callOrder, TelephonyGateway& gw)
+        : VoiceCallAlert(move(uid), move(msg), move(loc),
+                         make_shared<const vector<Contact>>(move(callOrder)), gw) {}
+    
+    // Ring the next contact, taking a gateway slot; seconds is set to how
+    // long the attempt lasts. False if every slot is in use (try again
+    // later) or nobody is left to call.
+    bool placeCall(double& seconds) {
+        if (activeTrunk >= 0 || nextContact >= contacts->size()) return false;
+        int trunk = gateway.openCall();
+        if (trunk < 0) return false;
+        activeTrunk = trunk;
+        lastOutcome = gateway.ring((*contacts)[nextContact].getPhone(), lastSeconds);
+        seconds = lastSeconds;
+        return true;
+    }
+    
+    // Hang up the call in progress and free its slot. True once the alert
+    // is settled: someone answered or every contact has been tried.
+    bool finishCall() {
+        if (activeTrunk < 0) return !answeredBy.empty() || nextContact >= contacts->size();
+        gateway.closeCall(activeTrunk);
+        activeTrunk = -1;
+        const Contact& contact = (*contacts)[nextContact++];
+        callsMade++;
+        elapsedSeconds += lastSeconds;
+        if (lastOutcome == CALL_ANSWERED) {
+            answeredBy = contact.getName();
+            status = "answered";
+            countSent();
+            return true;
+        }
+        if (nextContact < contacts->size()) return false;
+        status = "unanswered";
+        return true;
+    }
+    
+    // POLYMORPHISM: Override sendAlert method. If every call slot is in
+    // use the alert is left "line busy" with its place in the call list
+    // kept, so sending it again carries on from the next contact.
+    bool sendAlert() override {
+        out() << "\n[Voice Call] Calling " << contacts->size() << " contacts until one answers..." << endl;
+        while (nextContact < contacts->size()) {
+            const Contact& contact = (*contacts)[nextContact];
+            double seconds;
+            if (!placeCall(seconds)) {
+                out() << "  → All call slots busy, alert requeued" << endl;
+                status = "line busy";
+                return false;
+            }
+            bool settled = finishCall(); // Waits out the call
+            
+            out() << "  → Calling " << contact.getName() << " (" << contact.getPhone() << "): ";
+            if (lastOutcome == CALL_ANSWERED) {
+                out() << "answered after " << (int)seconds << "s" << endl;
+                out() << "    Playing message: " << *message << endl;
+                return true;
+            }
+            out() << (lastOutcome == CALL_BUSY ? "busy" : "no answer") << endl;
+            if (settled) break;
+        }
+        status = "unanswered";
+        return false;
+    }
+    
+    // POLYMORPHISM: Override getAlertDetails
+    string getAlertDetails() override {
+        if (answeredBy.empty()) {
+            return "Voice Call Alert unanswered after " + to_string(callsMade) + " calls";
+        }
+        return "Voice Call Alert answered by " + answeredBy + " after " + to_string(callsMade) +
+               " calls (" + to_string((int)elapsedSeconds) + "s)";
+    }
+};
+
+// Load test: run many VoiceCallAlerts at once against the gateway's
+// limited slots (discrete-event simulation, simulated seconds). Each alert
+// calls its contacts in order and holds a slot for the whole ring, so
+// cascades queue for slots the way they would in production.
+void simulateCallLoad(TelephonyGateway& gateway, int cascades, int contactsPerCascade) {
+    struct CallDone {
+        double time;
+        int cascade;
+        bool operator>(const CallDone& other) const { return time > other.time; }
+    };
+    
+    SharedText message = "This is an automated emergency call. Please call back immediately.";
+    SharedLocation location = Location();
+    auto callOrder = make_shared<vector<Contact>>(); // One list shared by every cascade
+    for (int k = 0; k < contactsPerCascade; k++) {
+        callOrder->emplace_back("Contact " + to_string(k + 1), "+1555010" + to_string(1000 + k), "",
+                               "Emergency", "", contactsPerCascade - k);
+    }
+    vector<unique_ptr<VoiceCallAlert>> alerts;
+    alerts.reserve(cascades);
+    for (int i = 0; i < cascades; i++) {
+        alerts.emplace_back(new VoiceCallAlert("load_user" + to_string(i), message, location, callOrder, gateway));
+    }
+    
+    priority_queue<CallDone, vector<CallDone>, greater<CallDone>> inFlight;
+    deque<int> waiting;
+    vector<double> latencies;
+    int calls = 0, unanswered = 0;
+    double now = 0.0;
+    
+    for (int i = 0; i < cascades; i++) waiting.push_back(i);
+    
+    auto startCalls = [&]() {
+        while (!waiting.empty()) {
+            double seconds;
+            if (!alerts[waiting.front()]->placeCall(seconds)) return; // Wait for a slot to free up
+            inFlight.push({now + seconds, waiting.front()});
+            waiting.pop_front();
+            calls++;
+        }
+    };
+    
+    startCalls();
+    while (!inFlight.empty()) {
+        CallDone done = inFlight.top();
+        inFlight.pop();
+        now = done.time;
+        VoiceCallAlert& alert = *alerts[done.cascade];
+        if (!alert.finishCall()) {
+            waiting.push_back(done.cascade); // Escalate to the next contact
+        } else if (alert.getStatus() == "answered") {
+            latencies.push_back(now);
+        } else {
+            unanswered++;
+        }
+        startCalls();
+    }
+    
+    sort(latencies.begin(), latencies.end());
+    cout << "Cascades: " << cascades << ", call slots: " << gateway.totalSlots()
+         << ", calls placed: " << calls << endl;
+    cout << "Simulated duration: " << (int)now << "s ("
+         << (int)(calls * 60.0 / max(now, 1.0)) << " calls/min)" << endl;
+    if (!latencies.empty()) {
+        cout << "Escalation latency p50: " << (int)latencies[latencies.size() / 2] << "s, p95: "
+             << (int)latencies[latencies.size() * 95 / 100] << "s" << endl;
+    }
+    cout << "Unanswered cascades: " << unanswered << endl;
+}
+
+// ==================== PRIORITY CASCADE ====================
+// Timer subsystem: a min-heap of deadlines. The owner calls popDue() with
+// the current time and handles whatever expired, so any number of timers
+// run on one thread. Each timer carries a generation so the owner can
+// tell a timer for the current run of a key from one left by an earlier run.
+class TimerQueue {
+public:
+    struct Due {
+        string key;
+        uint64_t generation;
+    };
+
+private:
+    struct Timer {
+        time_t deadline;
+        string key;
+        uint64_t generation;
+        bool operator>(const Timer& other) const { return deadline > other.deadline; }
+    };
+    priority_queue<Timer, vector<Timer>, greater<Timer>> timers;
+
+public:
+    void schedule(time_t deadline, const string& key, uint64_t generation) {
+        timers.push({deadline, key, generation});
+    }
+
+    // Collect every timer due at or before now
+    void popDue(time_t now, vector<Due>& due) {
+        while (!timers.empty() && timers.top().deadline <= now) {
+            due.push_back({timers.top().key, timers.top().generation});
+            timers.pop();
+        }
+    }
+
+    size_t size() const { return timers.size(); }
+};
+
+// Notifies a user's contacts in priority tiers: the top tier at once, the
+// next tier only if nobody acknowledged within the tier timeout.
+class CascadeEngine {
+public:
+    typedef function<void(const string& alertId, const string& message,
+                          const vector<Contact>& tier)> Notifier;
+
+private:
+    // Per-alert state: contacts are shared, the cascade only keeps a cursor
+    struct Cascade {
+        SharedText message;
+        shared_ptr<const vector<Contact>> contacts; // Sorted by priority
+        size_t next;   // First contact not yet notified
+        int tier;
+        uint64_t generation; // Timers from other runs of this alert are ignored
+    };
+    unordered_map<string, Cascade> cascades; // alertId -> state
+    TimerQueue timers;
+    int tierTimeoutSeconds;
+    Notifier notifier;
+    uint64_t nextGeneration;
+
+    // Notify every contact sharing the next priority level. The cascade is
+    // advanced (or erased) before the notifier runs, since the notifier
+    // may acknowledge the alert and free the cascade.
+    void notifyNextTier(string alertId, Cascade& cascade, time_t now) {
+        shared_ptr<const vector<Contact>> contacts = cascade.contacts;
+        SharedText message = cascade.message;
+        size_t end = cascade.next;
+        while (end < contacts->size() && (*contacts)[end].getPriority() == (*contacts)[cascade.next].getPriority()) {
+            end++;
+        }
+        vector<Contact> tier(contacts->begin() + cascade.next, contacts->begin() + end);
+        cascade.next = end;
+        cascade.tier++;
+        
+        if (cascade.next < contacts->size()) {
+            timers.schedule(now + tierTimeoutSeconds, alertId, cascade.generation);
+        } else {
+            cascades.erase(alertId); // Nobody left to escalate to
+        }
+        notifier(alertId, *message, tier);
+    }
+
+public:
+    CascadeEngine(int timeoutSeconds, Notifier notify)
+        : tierTimeoutSeconds(timeoutSeconds), notifier(move(notify)), nextGeneration(1) {}
+
+    bool start(const Alert& alert, const User& user, time_t now) {
+        return start(alert, make_shared<const vector<Contact>>(user.getContactsByPriority()), now);
+    }
+
+    // Contacts must already be sorted by priority; many cascades may share them.
+    // Refuses an alert whose cascade is still running (acknowledge it first).
+    bool start(const Alert& alert, shared_ptr<const vector<Contact>> contacts, time_t now) {
+        if (contacts->empty()) return false;
+        auto inserted = cascades.emplace(alert.getId(),
+                                         Cascade{alert.getSharedMessage(), contacts, 0, 0, nextGeneration});
+        if (!inserted.second) {
+            cerr << "Error: Cascade already running for alert " << alert.getId() << endl;
+            return false;
+        }
+        nextGeneration++;
+        notifyNextTier(alert.getId(), inserted.first->second, now);
+        return true;
+    }
+
+    // A contact responded: stop escalating this alert
+    bool acknowledge(const string& alertId) {
+        return cascades.erase(alertId) > 0;
+    }
+
+    // Escalate every cascade whose tier timed out
+    void tick(time_t now) {
+        vector<TimerQueue::Due> due;
+        timers.popDue(now, due);
+        for (const auto& timer : due) {
+            auto it = cascades.find(timer.key);
+            // Acknowledged meanwhile, or a timer from an earlier run of the alert
+            if (it == cascades.end() || it->second.generation != timer.generation) continue;
+            notifyNextTier(timer.key, it->second, now);
+        }
+    }
+
+    size_t activeCount() const { return cascades.size(); }
+};
+
+// ==================== SHARDING ====================
+// Consistent hash ring: each node owns many points ("virtual nodes") on
+// the ring and a key belongs to the first point clockwise from its hash.
+// Adding or removing a node only moves the keys next to its points.
+class ConsistentHashRing {
+private:
+    int virtualNodes;
+    map<uint64_t, string> ring; // ring position -> node name
+
+public:
+    // Ring positions (after, upTo] owned by one of a node's points, and
+    // the node that owned them before that point was added. Wraps past
+    // the top of the ring when after >= upTo.
+    struct Range {
+        uint64_t after;
+        uint64_t upTo;
+        string previousOwner;
+    };
+
+    // Ring position of a key. FNV-1a with a final avalanche step so that
+    // keys differing only in their last characters still land far apart.
+    // Stable across runs and platforms, unlike std::hash.
+    static uint64_t hash(const string& key) {
+        uint64_t h = 1469598103934665603ULL;
+        for (unsigned char c : key) {
+            h ^= c;
+            h *= 1099511628211ULL;
+        }
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+
+    ConsistentHashRing(int vnodes = 64) : virtualNodes(vnodes) {}
+
+    void addNode(const string& node) {
+        for (int i = 0; i < virtualNodes; i++) {
+            ring[hash(node + "#" + to_string(i))] = node;
+        }
+    }
+
+    void removeNode(const string& node) {
+        for (int i = 0; i < virtualNodes; i++) {
+            ring.erase(hash(node + "#" + to_string(i)));
+        }
+    }
+
+    string nodeFor(const string& key) const {
+        if (ring.empty()) return "";
+        auto it = ring.lower_bound(hash(key));
+        if (it == ring.end()) it = ring.begin(); // Wrap around
+        return it->second;
+    }
+
+    // The ranges a node's points own. Each one's previous owner is the
+    // first node clockwise that is not this node. Empty if it is the only node.
+    vector<Range> rangesOf(const string& node) const {
+        vector<Range> ranges;
+        for (int i = 0; i < virtualNodes; i++) {
+            auto point = ring.find(hash(node + "#" + to_string(i)));
+            if (point == ring.end() || point->second != node) continue; // Lost to a collision
+            auto before = point == ring.begin() ? prev(ring.end()) : prev(point);
+            auto owner = point;
+            do {
+                if (++owner == ring.end()) owner = ring.begin();
+            } while (owner->second == node && owner != point);
+            if (owner == point) return {}; // Nobody else on the ring
+            ranges.push_back({before->first, point->first, owner->second});
+        }
+        return ranges;
+    }
+
+    bool empty() const { return ring.empty(); }
+};
+
+// Keeps each user (with contacts) on the node that owns it and routes
+// alert triggers to that node
+class ShardedDirectory {
+private:
+    // Users are ordered by ring position, so the users in one ring range
+    // can be found without scanning the whole shard
+    typedef pair<uint64_t, string> RingKey;
+    typedef map<RingKey, User> Shard;
+
+    ConsistentHashRing ring;
+    map<string, Shard> shards; // node -> users
+
+    static RingKey keyFor(const string& userId) { return RingKey(ConsistentHashRing::hash(userId), userId); }
+
+    // Move users from `from` starting at `it` until the ring position
+    // passes upTo; returns how many moved
+    static int moveUntil(Shard& from, Shard& to, Shard::iterator it, uint64_t upTo) {
+        int moved = 0;
+        while (it != from.end() && it->first.first <= upTo) {
+            to.emplace(it->first, move(it->second));
+            it = from.erase(it);
+            moved++;
+        }
+        return moved;
+    }
+
+    // Hand the ranges a newly added node took over from their previous
+    // owners to it; only users in those ranges are visited
+    int takeOver(const string& node) {
+        int moved = 0;
+        Shard& to = shards[node];
+        for (const auto& range : ring.rangesOf(node)) {
+            Shard& from = shards[range.previousOwner];
+            auto it = from.lower_bound(RingKey(range.after, ""));
+            while (it != from.end() && it->first.first == range.after) ++it; // Exclusive lower end
+            if (range.after < range.upTo) {
+                moved += moveUntil(from, to, it, range.upTo);
+            } else {
+                moved += moveUntil(from, to, it, UINT64_MAX);
+                moved += moveUntil(from, to, from.begin(), range.upTo); // Wrapped past the top
+            }
+        }
+        return moved;
+    }
+
+public:
+    ShardedDirectory(int vnodes = 64) : ring(vnodes) {}
+
+    int addNode(const string& node) {
+        ring.addNode(node);
+        shards[node];
+        int moved = takeOver(node);
+        cout << "✓ Node joined: " << node << " (" << moved << " users moved)" << endl;
+        return moved;
+    }
+
+    int removeNode(const string& node) {
+        if (!shards.count(node)) return 0;
+        ring.removeNode(node);
+        if (ring.empty()) {
+            cerr << "Error: Cannot remove the last node: " << node << endl;
+            ring.addNode(node);
+            return 0;
+        }
+        Shard leaving;
+        leaving.swap(shards[node]);
+        shards.erase(node);
+        for (auto& entry : leaving) {
+            shards[ring.nodeFor(entry.first.second)].emplace(entry.first, move(entry.second));
+        }
+        cout << "✓ Node left: " << node << " (" << leaving.size() << " users moved)" << endl;
+        return (int)leaving.size();
+    }
+
+    bool addUser(const User& user) {
+        if (ring.empty()) return false;
+        shards[ring.nodeFor(user.getUserId())].emplace(keyFor(user.getUserId()), user);
+        return true;
+    }
+
+    // Node that owns the user who triggered the alert
+    string routeAlert(const Alert& alert) const {
+        return ring.nodeFor(alert.getUserId());
+    }
+
+    void displayShards() const {
+        for (const auto& shard : shards) {
+            cout << "  " << shard.first << ": " << shard.second.size() << " users" << endl;
+        }
+    }
+};
+
+// ==================== BINARY ALERT PROTOCOL ====================
+// Compact framing for partners that push alerts in bulk. One frame carries
+// a batch of triggers; frames are length-prefixed so many can be sent
+// back to back on one stream without waiting for replies (pipelining).
+//
+// Frame layout (all integers little-endian):
+//   u32 length        bytes after this field
+//   u8  frameType     1 = trigger batch
+//   u32 requestId     echoed in the reply so pipelined requests can match
+//   u16 count         triggers in this frame
+//   count x trigger:
+//     u8  channel     see AlertChannel
+//     f64 latitude, f64 longitude
+//     str userId, str message, str address   (u16 length + bytes)
+//     u16 recipients, then that many str
+
+// One alert request as carried on the wire
+struct AlertTrigger {
+    AlertChannel channel;
+    string userId;
+    string message;
+    Location location;
+    vector<string> recipients; // Authority alerts: recipients[0] is the authority type
+};
+
+// Build the matching Alert subclass for a decoded trigger
+shared_ptr<Alert> createAlert(const AlertTrigger& trigger) {
+    switch (trigger.channel) {
+        case CHANNEL_SMS:
+            return make_shared<SMSAlert>(trigger.userId, trigger.message, trigger.location, trigger.recipients);
+        case CHANNEL_EMAIL:
+            return make_shared<EmailAlert>(trigger.userId, trigger.message, trigger.location, trigger.recipients);
+        case CHANNEL_AUTHORITY:
+            return make_shared<AuthorityAlert>(trigger.userId, trigger.message, trigger.location,
+                                               trigger.recipients.empty() ? "police" : trigger.recipients[0]);
+        case CHANNEL_PUSH:
+            return make_shared<PushNotificationAlert>(trigger.userId, trigger.message, trigger.location, trigger.recipients);
+        case CHANNEL_VOICE:
+            break; // Voice alerts need contacts and a gateway; not accepted on the wire
+        case CHANNEL_UNKNOWN:
+            break;
+    }
+    return nullptr;
+}
+
+class FrameCodec {
+private:
+    static void putU8(string& out, uint8_t v) { out.push_back((char)v); }
+    static void putU16(string& out, uint16_t v) {
+        for (int i = 0; i < 2; i++) out.push_back((char)(v >> (8 * i)));
+    }
+    static void putU32(string& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out.push_back((char)(v >> (8 * i)));
+    }
+    static void putF64(string& out, double d) {
+        uint64_t v;
+        memcpy(&v, &d, sizeof(v));
+        for (int i = 0; i < 8; i++) out.push_back((char)(v >> (8 * i)));
+    }
+    static const size_t MAX_FIELD = 0xFFFF; // Strings and counts carry a u16 length
+    
+    static void putStr(string& out, const string& str) {
+        putU16(out, (uint16_t)str.size());
+        out += str;
+    }
+    
+    static bool fieldsFit(const AlertTrigger& t) {
+        if (t.userId.size() > MAX_FIELD || t.message.size() > MAX_FIELD ||
+            t.location.getAddress().size() > MAX_FIELD || t.recipients.size() > MAX_FIELD) {
+            return false;
+        }
+        for (const auto& r : t.recipients) {
+            if (r.size() > MAX_FIELD) return false;
+        }
+        return true;
+    }
+
+    // Bounds-checked reader over a frame body
+    class Reader {
+    private:
+        const unsigned char* pos;
+        const unsigned char* end;
+
+        uint64_t getLE(int bytes) {
+            uint64_t v = 0;
+            for (int i = 0; i < bytes; i++) v |= (uint64_t)pos[i] << (8 * i);
+            pos += bytes;
+            return v;
+        }
+
+    public:
+        Reader(const char* data, size_t size)
+            : pos((const unsigned char*)data), end((const unsigned char*)data + size) {}
+
+        bool has(size_t bytes) const { return (size_t)(end - pos) >= bytes; }
+        bool u8(uint8_t& v) { if (!has(1)) return false; v = (uint8_t)getLE(1); return true; }
+        bool u16(uint16_t& v) { if (!has(2)) return false; v = (uint16_t)getLE(2); return true; }
+        bool u32(uint32_t& v) { if (!has(4)) return false; v = (uint32_t)getLE(4); return true; }
+        bool f64(double& d) {
+            if (!has(8)) return false;
+            uint64_t v = getLE(8);
+            memcpy(&d, &v, sizeof(d));
+            return true;
+        }
+        // Strings are built straight from the frame bytes
+        bool str(string& s) {
+            uint16_t len;
+            if (!u16(len) || !has(len)) return false;
+            s.assign((const char*)pos, len);
+            pos += len;
+            return true;
+        }
+    };
+
+public:
+    static const uint8_t FRAME_TRIGGER_BATCH = 1;
+    static const uint32_t MAX_FRAME = 16 * 1024 * 1024;
+
+    // Encode a batch of triggers as one frame and append it to out.
+    // Fails, leaving out unchanged, if a field or the frame is too large.
+    static bool encodeBatch(string& out, uint32_t requestId, const vector<AlertTrigger>& triggers) {
+        if (triggers.size() > MAX_FIELD) {
+            cerr << "Error: Too many triggers for one frame: " << triggers.size() << endl;
+            return false;
+        }
+        for (const auto& t : triggers) {
+            if (!fieldsFit(t)) {
+                cerr << "Error: Trigger field longer than " << MAX_FIELD << " from user "
+                     << t.userId.substr(0, 64) << endl;
+                return false;
+            }
+        }
+        size_t start = out.size();
+        putU32(out, 0); // Length, patched below
+        putU8(out, FRAME_TRIGGER_BATCH);
+        putU32(out, requestId);
+        putU16(out, (uint16_t)triggers.size());
+        for (const auto& t : triggers) {
+            putU8(out, t.channel);
+            putF64(out, t.location.getLatitude());
+            putF64(out, t.location.getLongitude());
+            putStr(out, t.userId);
+            putStr(out, t.message);
+            putStr(out, t.location.getAddress());
+            putU16(out, (uint16_t)t.recipients.size());
+            for (const auto& r : t.recipients) putStr(out, r);
+        }
+        size_t length = out.size() - start - 4;
+        if (length > MAX_FRAME) {
+            cerr << "Error: Frame of " << length << " bytes exceeds the limit" << endl;
+            out.resize(start);
+            return false;
+        }
+        for (int i = 0; i < 4; i++) out[start + i] = (char)(length >> (8 * i));
+        return true;
+    }
+
+    // Decode one frame body (without its length prefix) and append its
+    // triggers. On failure nothing is appended.
+    static bool decodeBatch(const char* body, size_t size, uint32_t& requestId,
+                            vector<AlertTrigger>& triggers) {
+        size_t before = triggers.size();
+        if (decodeInto(body, size, requestId, triggers)) return true;
+        triggers.resize(before);
+        return false;
+    }
+
+private:
+    static const size_t MIN_TRIGGER = 1 + 8 + 8 + 2 * 3 + 2; // Channel, lat, lng, 3 empty strings, count
+    
+    static bool decodeInto(const char* body, size_t size, uint32_t& requestId, vector<AlertTrigger>& triggers) {
+        Reader in(body, size);
+        uint8_t frameType;
+        uint16_t count;
+        if (!in.u8(frameType) || frameType != FRAME_TRIGGER_BATCH) return false;
+        if (!in.u32(requestId) || !in.u16(count)) return false;
+        if (!in.has((size_t)count * MIN_TRIGGER)) return false;
+        
+        triggers.reserve(triggers.size() + count);
+        for (uint16_t i = 0; i < count; i++) {
+            AlertTrigger t;
+            uint8_t channel;
+            uint16_t recipients;
+            double lat, lng;
+            string address;
+            if (!in.u8(channel) || channel < CHANNEL_SMS || channel > CHANNEL_PUSH) return false; // No voice
+            if (!in.f64(lat) || !in.f64(lng)) return false;
+            if (!in.str(t.userId) || !in.str(t.message) || !in.str(address)) return false;
+            if (!in.u16(recipients) || !in.has((size_t)recipients * 2)) return false; // Each needs its length
+            t.recipients.resize(recipients);
+            for (auto& r : t.recipients) {
+                if (!in.str(r)) return false;
+            }
+            t.channel = (AlertChannel)channel;
+            t.location = Location(lat, lng, address);
+            triggers.push_back(move(t));
+        }
+        return !in.has(1); // Trailing bytes mean a malformed frame
+    }
+};
+
+// One decoded frame; the reply carries requestId so the partner can match
+// it to the pipelined request
+struct DecodedFrame {
+    uint32_t requestId;
+    vector<AlertTrigger> triggers;
+};
+
+// Reassembles frames from a byte stream. Bytes may arrive in any chunking;
+// every complete frame is decoded as soon as its last byte is in.
+class FrameDecoder {
+private:
+    string buffer;
+    size_t consumed;
+
+public:
+    FrameDecoder() : consumed(0) {}
+
+    // Appends each complete frame. Returns false if the stream is corrupt
+    // and the connection should close.
+    bool feed(const char* data, size_t size, vector<DecodedFrame>& frames) {
+        buffer.append(data, size);
+        while (buffer.size() - consumed >= 4) {
+            const unsigned char* head = (const unsigned char*)buffer.data() + consumed;
+            uint32_t length = head[0] | (head[1] << 8) | (head[2] << 16) | ((uint32_t)head[3] << 24);
+            if (length > FrameCodec::MAX_FRAME) return false;
+            if (buffer.size() - consumed - 4 < length) break; // Wait for more bytes
+            
+            DecodedFrame frame;
+            if (!FrameCodec::decodeBatch(buffer.data() + consumed + 4, length, frame.requestId, frame.triggers)) {
+                return false;
+            }
+            frames.push_back(move(frame));
+            consumed += 4 + length;
+        }
+        // Drop consumed bytes once they dominate the buffer
+        if (consumed > 0 && consumed * 2 >= buffer.size()) {
+            buffer.erase(0, consumed);
+            consumed = 0;
+        }
+        return true;
+    }
+};
+
+// ==================== DEBOUNCE ====================
+// A panicking user may press the button many times. Repeated triggers of
+// the same type from the same user within the window update the alert
+// that is already open (message and location) instead of notifying
+// everyone again. Each press extends the window.
+class AlertDebouncer {
+private:
+    // (user, channel) without building a string. The user id is the
+    // triggering alert's own, held through an aliasing shared_ptr that
+    // keeps that alert alive until the entry expires; the hash is
+    // computed once per trigger.
+    struct Key {
+        shared_ptr<const string> userId;
+        AlertChannel channel;
+        size_t hash;
+
+        explicit Key(const shared_ptr<Alert>& alert)
+            : userId(alert, &alert->getUserId()), channel(alert->getChannel()),
+              hash(std::hash<string>()(*userId) * 31 + channel) {}
+
+        bool operator==(const Key& other) const {
+            return channel == other.channel && *userId == *other.userId;
+        }
+    };
+    struct KeyHash {
+        size_t operator()(const Key& key) const { return key.hash; }
+    };
+    struct OpenAlert {
+        shared_ptr<Alert> alert; // Null until the first trigger fills it in
+        time_t lastTrigger;
+    };
+    unordered_map<Key, OpenAlert, KeyHash> open;
+    int windowSeconds;
+    int merged;
+
+public:
+    AlertDebouncer(int window = 30) : windowSeconds(window), merged(0) {}
+
+    // Returns true if the alert is new and should be sent; false if it
+    // was merged into the user's open alert on the same channel
+    bool admit(const shared_ptr<Alert>& alert, time_t now) {
+        // operator[] does the only hash lookup, and only allocates when
+        // the user has no open alert yet
+        OpenAlert& current = open[Key(alert)];
+        if (!current.alert || now - current.lastTrigger > windowSeconds) {
+            current = OpenAlert{alert, now}; // New, or window over: a fresh alert
+            return true;
+        }
+        current.alert->setMessage(alert->getSharedMessage());
+        current.alert->setLocation(alert->getSharedLocation());
+        current.lastTrigger = now;
+        merged++;
+        return false;
+    }
+
+    // Triggers merged into an already open alert so far
+    int mergedCount() const { return merged; }
+
+    // Forget windows that have closed
+    void expire(time_t now) {
+        for (auto it = open.begin(); it != open.end();) {
+            it = now - it->second.lastTrigger > windowSeconds ? open.erase(it) : next(it);
+        }
+    }
+
+    size_t openCount() const { return open.size(); }
+};
+
+// ==================== LIVE ALERT FEED ====================
+// Dashboard subscribers receive alert "created" and "status" events.
+// Each subscriber only sees alerts inside its region and of its type.
+
+// Region (bounding box) and alert type a subscriber is interested in
+struct FeedFilter {
+    double minLat, minLng, maxLat, maxLng;
+    string type; // Empty string means every alert type
+
+    FeedFilter(double loLat = -90.0, double loLng = -180.0,
+               double hiLat = 90.0, double hiLng = 180.0, string t = "")
+        : minLat(loLat), minLng(loLng), maxLat(hiLat), maxLng(hiLng), type(move(t)) {}
+
+    bool matches(const Alert& alert) const {
+        const Location& loc = alert.getLocation();
+        if (!type.empty() && type != alert.getType()) return false;
+        return loc.getLatitude() >= minLat && loc.getLatitude() <= maxLat &&
+               loc.getLongitude() >= minLng && loc.getLongitude() <= maxLng;
+    }
+};
+
+// A connected dashboard. Frames are shared, never copied per subscriber.
+// A dashboard that stops reading keeps at most MAX_PENDING frames: the
+// oldest are dropped first, since newer events supersede them. The cap
+// comes from the 4KB per-connection budget: 128 frame pointers are 2KB
+// (at most 2.5KB of deque blocks), leaving room for the name and filter.
+// Frame text is shared by every subscriber, so it is not charged to a
+// connection.
+class FeedSubscriber {
+public:
+    static const size_t MAX_PENDING = 128;
+
+private:
+    string name;
+    FeedFilter filter;
+    deque<shared_ptr<const string>> pending;
+    size_t dropped;
+
+public:
+    FeedSubscriber(string n, FeedFilter f) : name(move(n)), filter(move(f)), dropped(0) {}
+
+    const string& getName() const { return name; }
+    const FeedFilter& getFilter() const { return filter; }
+    size_t pendingCount() const { return pending.size(); }
+    size_t droppedCount() const { return dropped; }
+
+    void deliver(const shared_ptr<const string>& frame) {
+        if (pending.size() >= MAX_PENDING) {
+            pending.pop_front();
+            dropped++;
+        }
+        pending.push_back(frame);
+    }
+
+    // Write out queued frames (stands in for the socket write)
+    size_t flush() {
+        size_t sent = pending.size();
+        for (const auto& frame : pending) {
+            cout << "  [" << name << "] " << *frame << endl;
+        }
+        pending.clear();
+        return sent;
+    }
+};
+
+class AlertFeed {
+private:
+    vector<shared_ptr<FeedSubscriber>> subscribers;
+
+    static string escape(const string& text) {
+        static const char hex[] = "0123456789abcdef";
+        string out;
+        for (char c : text) {
+            switch (c) {
+                case '"': out += "\\\""; break;
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\r': out += "\\r"; break;
+                case '\t': out += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20) {
+                        out += "\\u00";
+                        out += hex[(unsigned char)c >> 4];
+                        out += hex[c & 0xf];
+                    } else {
+                        out += c;
+                    }
+            }
+        }
+        return out;
+    }
+
+    // Encode an event as the JSON text frame sent to dashboards
+    static string encodeEvent(const string& event, const Alert& alert) {
+        ostringstream frame;
+        frame << "{\"event\":\"" << event << "\""
+              << ",\"id\":\"" << escape(alert.getId()) << "\""
+              << ",\"type\":\"" << alert.getType() << "\""
+              << ",\"status\":\"" << alert.getStatus() << "\""
+              << ",\"lat\":" << alert.getLocation().getLatitude()
+              << ",\"lng\":" << alert.getLocation().getLongitude()
+              << ",\"message\":\"" << escape(alert.getMessage()) << "\"}";
+        return frame.str();
+    }
+
+public:
+    shared_ptr<FeedSubscriber> subscribe(const string& name, const FeedFilter& filter) {
+        subscribers.push_back(make_shared<FeedSubscriber>(name, filter));
+        return subscribers.back();
+    }
+
+    void unsubscribe(const string& name) {
+        for (auto it = subscribers.begin(); it != subscribers.end(); ++it) {
+            if ((*it)->getName() == name) {
+                subscribers.erase(it);
+                return;
+            }
+        }
+    }
+
+    // Encode the event once (only if someone wants it) and share the
+    // same buffer with every matching subscriber. Returns delivery count.
+    int publish(const string& event, const Alert& alert) {
+        shared_ptr<const string> frame;
+        int delivered = 0;
+        for (auto& subscriber : subscribers) {
+            if (!subscriber->getFilter().matches(alert)) continue;
+            if (!frame) frame = make_shared<const string>(encodeEvent(event, alert));
+            subscriber->deliver(frame);
+            delivered++;
+        }
+        return delivered;
+    }
+
+    size_t subscriberCount() const { return subscribers.size(); }
+};
+
+// ==================== TRACE CAPTURE & REPLAY ====================
+// Records incoming triggers and the provider's response, with timing, so
+// a production traffic shape can be replayed against a new build.
+//
+// Trace file: "ETRC" then one record per trigger (little-endian):
+//   u64 microseconds since the trace started
+//   u32 provider response time in microseconds
+//   u8  delivered (1) or failed (0)
+//   one FrameCodec trigger-batch frame holding the trigger
+class TraceRecorder {
+private:
+    ofstream out;
+    long records;
+
+    void putLE(uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) out.put((char)(value >> (8 * i)));
+    }
+
+public:
+    TraceRecorder(const string& filename) : out(filename, ios::binary | ios::trunc), records(0) {
+        if (!out.is_open()) {
+            cerr << "Error: Could not open trace file for writing: " << filename << endl;
+            return;
+        }
+        out.write("ETRC", 4);
+    }
+
+    bool record(double atSeconds, const AlertTrigger& trigger, double providerSeconds, bool delivered) {
+        if (!out.is_open()) return false;
+        string frame;
+        if (!FrameCodec::encodeBatch(frame, (uint32_t)records, {trigger})) return false;
+        putLE((uint64_t)(atSeconds * 1e6), 8);
+        putLE((uint32_t)(providerSeconds * 1e6), 4);
+        putLE(delivered ? 1 : 0, 1);
+        out.write(frame.data(), frame.size());
+        records++;
+        return out.good();
+    }
+
+    long recordCount() const { return records; }
+};
+
+class TraceReplayer {
+private:
+    struct Record {
+        double at;
+        double providerSeconds;
+        bool delivered;
+        AlertTrigger trigger;
+    };
+    vector<Record> records;
+
+    static uint64_t getLE(const unsigned char* bytes, int count) {
+        uint64_t value = 0;
+        for (int i = 0; i < count; i++) value |= (uint64_t)bytes[i] << (8 * i);
+        return value;
+    }
+
+public:
+    bool load(const string& filename) {
+        ifstream in(filename, ios::binary);
+        if (!in.is_open()) {
+            cerr << "Error: Could not open trace file for reading: " << filename << endl;
+            return false;
+        }
+        string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        if (data.compare(0, 4, "ETRC") != 0) {
+            cerr << "Error: Not a trace file: " << filename << endl;
+            return false;
+        }
+        
+        records.clear();
+        size_t pos = 4;
+        const size_t header = 8 + 4 + 1 + 4;
+        while (pos + header <= data.size()) {
+            const unsigned char* bytes = (const unsigned char*)data.data() + pos;
+            uint32_t frameLength = (uint32_t)getLE(bytes + 13, 4);
+            if (pos + header + frameLength > data.size()) break; // Truncated tail
+            
+            vector<AlertTrigger> triggers;
+            uint32_t requestId;
+            if (!FrameCodec::decodeBatch(data.data() + pos + header, frameLength, requestId, triggers) ||
+                triggers.size() != 1) {
+                cerr << "Error: Corrupt trace record at byte " << pos << endl;
+                return false;
+            }
+            records.push_back({getLE(bytes, 8) / 1e6, getLE(bytes + 8, 4) / 1e6, bytes[12] != 0, move(triggers[0])});
+            pos += header + frameLength;
+        }
+        return true;
+    }
+
+    // Feed the trace through the pipeline. speed 1 = recorded pace, N = N
+    // times faster, 0 = as fast as possible. Providers are local stubs that
+    // answer instantly with the recorded outcome.
+    void replay(double speed, AlertFeed& feed) {
+        if (records.empty()) return;
+        vector<double> lateness; // How far behind schedule each trigger ran
+        int failed = 0;
+        auto start = chrono::steady_clock::now();
+        for (const auto& rec : records) {
+            auto due = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                                   chrono::duration<double>(speed > 0 ? rec.at / speed : 0.0));
+            if (speed > 0) this_thread::sleep_until(due);
+            
+            shared_ptr<Alert> alert = createAlert(rec.trigger);
+            alert->setOutput(nullptr); // Channels print every send
+            alert->sendAlert();
+            if (!rec.delivered) { // Provider stub replays the recorded failure
+                alert->setStatus("failed");
+                failed++;
+            }
+            feed.publish("status", *alert);
+            lateness.push_back(chrono::duration<double>(chrono::steady_clock::now() - due).count());
+        }
+        double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        
+        sort(lateness.begin(), lateness.end());
+        cout << "  Replay at " << (speed > 0 ? to_string((int)speed) + "x" : string("max speed")) << ": "
+             << records.size() << " triggers in " << elapsed * 1000 << " ms ("
+             << (long)(records.size() / elapsed) << "/s), p99 behind schedule "
+             << lateness[lateness.size() * 99 / 100] * 1000 << " ms, " << failed << " provider failures" << endl;
+    }
+
+    size_t size() const { return records.size(); }
+    double duration() const { return records.empty() ? 0.0 : records.back().at; }
+};
+
+// ==================== SURGE SIMULATOR ====================
+// Generates synthetic alert traffic for capacity planning: users placed
+// around city hotspots or a disaster epicentre, Poisson or burst arrivals
+// and a configurable channel mix. Each trigger runs through the in-process
+// pipeline (createAlert -> sendAlert -> live feed) while the offered rate
+// ramps up, and the report shows where latency starts to climb.
+struct SurgeConfig {
+    int users = 1000;
+    bool disaster = false;            // true: one epicentre, false: city hotspots
+    double centerLat = 40.7128, centerLng = -74.0060;
+    double spreadKm = 5.0;
+    bool bursty = false;              // true: arrivals come in clumps of burstSize
+    int burstSize = 50;
+    double channelMix[4] = {0.4, 0.2, 0.1, 0.3}; // SMS, Email, Authority, Push
+    unsigned seed = 7;
+};
+
+class SurgeSimulator {
+private:
+    SurgeConfig config;
+    mt19937 rng;
+    vector<Location> homes;     // Where each synthetic user is
+    vector<Location> hotspots;
+
+    Location randomHome() {
+        normal_distribution<double> offset(0.0, config.spreadKm / 111.0); // ~111 km per degree
+        if (config.disaster) {
+            return Location(config.centerLat + offset(rng), config.centerLng + offset(rng), "Disaster area");
+        }
+        uniform_int_distribution<size_t> pick(0, hotspots.size() - 1);
+        const Location& spot = hotspots[pick(rng)];
+        return Location(spot.getLatitude() + offset(rng) / 4, spot.getLongitude() + offset(rng) / 4, spot.getAddress());
+    }
+
+    AlertTrigger randomTrigger() {
+        uniform_int_distribution<int> pickUser(0, config.users - 1);
+        discrete_distribution<int> pickChannel(config.channelMix, config.channelMix + 4);
+        int u = pickUser(rng);
+        AlertTrigger trigger;
+        trigger.channel = (AlertChannel)(CHANNEL_SMS + pickChannel(rng));
+        trigger.userId = "sim_user" + to_string(u);
+        trigger.message = "Simulated emergency from user " + to_string(u);
+        trigger.location = homes[u];
+        if (trigger.channel == CHANNEL_AUTHORITY) {
+            trigger.recipients = {"medical"};
+        } else if (trigger.channel == CHANNEL_EMAIL) {
+            trigger.recipients = {"contact" + to_string(u) + "@email.com"};
+        } else {
+            trigger.recipients = {"+1999" + to_string(1000000 + u)};
+        }
+        return trigger;
+    }
+
+    // Seconds between arrivals at the given mean rate
+    double nextGap(double ratePerSecond, int index) {
+        exponential_distribution<double> gap(ratePerSecond);
+        if (!config.bursty) return gap(rng);
+        // Bursts: same mean rate, but arrivals clump together
+        return index % config.burstSize == 0 ? gap(rng) * config.burstSize : 0.0;
+    }
+
+public:
+    SurgeSimulator(const SurgeConfig& cfg) : config(cfg), rng(cfg.seed) {
+        hotspots = {
+            Location(40.7580, -73.9855, "Midtown"), Location(40.7128, -74.0060, "Downtown"),
+            Location(40.6782, -73.9442, "Brooklyn"), Location(40.7282, -73.7949, "Queens")
+        };
+        for (int i = 0; i < config.users; i++) homes.push_back(randomHome());
+    }
+
+    // Offer `count` triggers at each rate in turn. Arrival times are
+    // simulated; service times are the measured cost of the pipeline, so
+    // queueing delay appears once the rate exceeds what one core handles.
+    // With a recorder, the generated traffic is also captured as a trace.
+    void runRamp(const vector<double>& rates, int count, AlertFeed& feed, TraceRecorder* recorder = nullptr) {
+        cout << "  rate/s     done/s    p50 ms    p99 ms" << endl;
+        double traceOffset = 0.0;
+        for (double rate : rates) {
+            vector<AlertTrigger> triggers;
+            vector<double> arrivals;
+            double clock = 0.0;
+            for (int i = 0; i < count; i++) {
+                clock += nextGap(rate, i);
+                arrivals.push_back(clock);
+                triggers.push_back(randomTrigger());
+            }
+            
+            vector<double> latencies;
+            double serverFree = 0.0;
+            for (int i = 0; i < count; i++) {
+                auto start = chrono::steady_clock::now();
+                shared_ptr<Alert> alert = createAlert(triggers[i]);
+                alert->setOutput(nullptr); // Channels print every send
+                bool delivered = alert->sendAlert();
+                feed.publish("status", *alert);
+                double service = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                if (recorder) recorder->record(traceOffset + arrivals[i], triggers[i], service, delivered);
+                double begin = max(arrivals[i], serverFree);
+                serverFree = begin + service;
+                latencies.push_back(serverFree - arrivals[i]);
+            }
+            traceOffset += arrivals.back();
+            
+            sort(latencies.begin(), latencies.end());
+            ostringstream row;
+            row << fixed << setprecision(0) << setw(10) << rate << setw(11) << count / max(serverFree, 1e-9)
+                << setprecision(3) << setw(10) << latencies[latencies.size() / 2] * 1000
+                << setw(10) << latencies[latencies.size() * 99 / 100] * 1000;
+            cout << row.str() << endl;
+        }
+    }
+};
+
+// ==================== HOT/COLD ALERT TABLE ====================
+// Scans over many alerts (by status, by age) only need a few small
+// fields. Those live in a dense array of 32-byte hot records, two per
+// cache line; the text fields live in a separate cold array at the same
+// row and are only touched when an alert is displayed or sent.
+enum AlertStatus : uint8_t {
+    STATUS_PENDING, STATUS_SENT, STATUS_DELIVERED, STATUS_DISPATCHED,
+    STATUS_ANSWERED, STATUS_UNANSWERED, STATUS_LINE_BUSY, STATUS_FAILED,
+    STATUS_FREE // Row holds no alert
+};
+
+AlertStatus statusFromString(const string& status) {
+    static const map<string, AlertStatus> codes = {
+        {"pending", STATUS_PENDING}, {"sent", STATUS_SENT}, {"delivered", STATUS_DELIVERED},
+        {"dispatched", STATUS_DISPATCHED}, {"answered", STATUS_ANSWERED},
+        {"unanswered", STATUS_UNANSWERED}, {"line busy", STATUS_LINE_BUSY}, {"failed", STATUS_FAILED}
+    };
+    auto it = codes.find(status);
+    return it == codes.end() ? STATUS_PENDING : it->second;
+}
+
+struct HotAlertRecord {
+    int64_t timestamp;
+    float latitude;
+    float longitude;
+    uint64_t userKey;      // Hash of the user ID, for filtering without the string
+    AlertChannel channel;
+    AlertStatus status;
+    uint8_t severity;      // 1-5, 0 if the channel has none
+    uint8_t reserved[5];
+};
+static_assert(sizeof(HotAlertRecord) == 32, "hot records must stay 32 bytes");
+
+struct ColdAlertRecord {
+    string id;
+    string userId;
+    SharedText message;
+    SharedLocation location;
+};
+
+class AlertTable {
+private:
+    vector<HotAlertRecord> hot;
+    vector<ColdAlertRecord> cold;
+
+public:
+    void reserve(size_t rows) {
+        hot.reserve(rows);
+        cold.reserve(rows);
+    }
+
+    // Returns the row of the new alert
+    uint32_t insert(const Alert& alert, uint8_t severity = 0) {
+        uint32_t row = (uint32_t)hot.size();
+        store(row, alert, severity);
+        return row;
+    }
+
+    // Write an alert into a row; row may be one past the end to append
+    void store(uint32_t row, const Alert& alert, uint8_t severity = 0) {
+        HotAlertRecord record = {};
+        record.timestamp = alert.getTimestamp();
+        record.latitude = (float)alert.getLocation().getLatitude();
+        record.longitude = (float)alert.getLocation().getLongitude();
+        record.userKey = hash<string>()(alert.getUserId());
+        record.channel = channelForType(alert.getType());
+        record.status = statusFromString(alert.getStatus());
+        record.severity = severity;
+        ColdAlertRecord text = {alert.getId(), alert.getUserId(), alert.getSharedMessage(), alert.getSharedLocation()};
+        if (row == hot.size()) {
+            hot.push_back(record);
+            cold.push_back(move(text));
+        } else {
+            hot[row] = record;
+            cold[row] = move(text);
+        }
+    }
+
+    // Mark a row empty so scans skip it and it can be reused
+    void release(uint32_t row) {
+        hot[row].status = STATUS_FREE;
+        cold[row] = ColdAlertRecord();
+    }
+
+    void setStatus(uint32_t row, AlertStatus status) { hot[row].status = status; }
+
+    const HotAlertRecord& hotRecord(uint32_t row) const { return hot[row]; }
+    const ColdAlertRecord& coldRecord(uint32_t row) const { return cold[row]; }
+
+    // Reads only the hot array
+    size_t countByStatus(AlertStatus status) const {
+        size_t count = 0;
+        for (const auto& record : hot) count += record.status == status;
+        return count;
+    }
+
+    // Scheduler pass: rows still in `status` that were created before cutoff
+    vector<uint32_t> olderThan(time_t cutoff, AlertStatus status) const {
+        vector<uint32_t> rows;
+        for (uint32_t row = 0; row < hot.size(); row++) {
+            if (hot[row].status == status && hot[row].timestamp < cutoff) rows.push_back(row);
+        }
+        return rows;
+    }
+
+    size_t size() const { return hot.size(); }
+};
+
+// ==================== ALERT STORE ====================
+// Owns alerts and hands out 64-bit generational handles instead of
+// shared_ptr. A handle is (slot index, generation): lookup is one array
+// access, copying it touches no reference count, and a handle to an
+// alert that has since been removed is detected because the slot's
+// generation has moved on. The slot index is also the alert's row in the
+// hot/cold AlertTable.
+//
+// Not synchronized. Any number of threads may call get() at once, and
+// send() may run alongside them for distinct handles, each handle being
+// touched by one thread at a time. add(), remove(), setStatus(),
+// syncStatus() and dispatch() reallocate or rewrite slots and hot
+// records and must not overlap any other call. Pipeline stages hand
+// handles across threads; the stage that owns the store makes the changes.
+typedef uint64_t AlertHandle;
+const AlertHandle NO_ALERT = 0; // Generations start at 1, so 0 is never issued
+
+class AlertStore {
+private:
+    struct Slot {
+        unique_ptr<Alert> alert;
+        uint32_t generation;
+    };
+    vector<Slot> slots;
+    vector<uint32_t> freeSlots;
+    AlertTable table;
+    size_t live;
+
+    static uint32_t indexOf(AlertHandle handle) { return (uint32_t)handle; }
+    static uint32_t generationOf(AlertHandle handle) { return (uint32_t)(handle >> 32); }
+
+    Alert* find(AlertHandle handle) const {
+        uint32_t index = indexOf(handle);
+        if (index >= slots.size() || slots[index].generation != generationOf(handle)) return nullptr;
+        return slots[index].alert.get();
+    }
+
+public:
+    AlertStore() : live(0) {}
+
+    AlertHandle add(unique_ptr<Alert> alert, uint8_t severity = 0) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            index = (uint32_t)slots.size();
+            slots.push_back({nullptr, 1});
+        }
+        table.store(index, *alert, severity);
+        slots[index].alert = move(alert);
+        live++;
+        return (AlertHandle)slots[index].generation << 32 | index;
+    }
+
+    // nullptr if the handle is stale or was never issued. Read-only, so
+    // status changes go through setStatus() or dispatch() and the hot
+    // record cannot drift from the object.
+    const Alert* get(AlertHandle handle) const { return find(handle); }
+
+    // A slot whose generation is exhausted is retired rather than wrapped
+    // back to an old value, which could make a stale handle valid again.
+    bool remove(AlertHandle handle) {
+        if (!find(handle)) return false;
+        uint32_t index = indexOf(handle);
+        slots[index].alert.reset();
+        table.release(index);
+        live--;
+        if (slots[index].generation == UINT32_MAX) return true; // Empty slot, never reused
+        slots[index].generation++; // Outstanding handles are now stale
+        freeSlots.push_back(index);
+        return true;
+    }
+
+    // Keeps the object and its hot record in step
+    bool setStatus(AlertHandle handle, const string& status) {
+        Alert* alert = find(handle);
+        if (!alert) return false;
+        alert->setStatus(status);
+        table.setStatus(indexOf(handle), statusFromString(status));
+        return true;
+    }
+
+    // Send the alert without touching its hot record, so worker stages
+    // can send through handles; the owner then calls syncStatus().
+    // False if the handle is stale or the send failed.
+    bool send(AlertHandle handle) const {
+        Alert* alert = find(handle);
+        return alert && alert->sendAlert();
+    }
+
+    // Copy the status an alert ended in to its hot record
+    bool syncStatus(AlertHandle handle) {
+        const Alert* alert = find(handle);
+        if (!alert) return false;
+        table.setStatus(indexOf(handle), statusFromString(alert->getStatus()));
+        return true;
+    }
+
+    // send() and syncStatus() together, for an owner sending in place
+    bool dispatch(AlertHandle handle) {
+        bool sent = send(handle);
+        syncStatus(handle);
+        return sent;
+    }
+
+    const AlertTable& getTable() const { return table; }
+    size_t size() const { return live; }
+};
+
+// ==================== ADDRESS MATCHING ====================
+// Free-text addresses ("123 Main St.", "123 main street") are normalized
+// to one canonical form, indexed by trigrams, and matched with a bounded
+// edit distance, so near-identical addresses can be found and deduped.
+
+// Edit distance between a and b, or maxDistance + 1 if it is larger.
+// Bit-parallel (Myers/Hyyro): one machine word per text character when
+// a has at most 64 characters; plain dynamic programming otherwise.
+int boundedEditDistance(const string& a, const string& b, int maxDistance) {
+    int m = (int)a.size(), n = (int)b.size();
+    if (abs(m - n) > maxDistance) return maxDistance + 1;
+    if (m == 0) return n;
+    
+    if (m <= 64) {
+        uint64_t peq[256] = {0};
+        for (int i = 0; i < m; i++) peq[(unsigned char)a[i]] |= 1ULL << i;
+        uint64_t pv = m == 64 ? ~0ULL : (1ULL << m) - 1, mv = 0;
+        uint64_t last = 1ULL << (m - 1);
+        int score = m;
+        for (int j = 0; j < n; j++) {
+            uint64_t eq = peq[(unsigned char)b[j]];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            if (ph & last) score++;
+            if (mh & last) score--;
+            ph = (ph << 1) | 1; // Row 0 grows by one per column (global distance)
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+            if (score - (n - 1 - j) > maxDistance) return maxDistance + 1; // Cannot recover
+        }
+        return score <= maxDistance ? score : maxDistance + 1;
+    }
+    
+    vector<int> row(m + 1);
+    for (int i = 0; i <= m; i++) row[i] = i;
+    for (int j = 1; j <= n; j++) {
+        int diagonal = row[0];
+        row[0] = j;
+        for (int i = 1; i <= m; i++) {
+            int up = row[i];
+            row[i] = min(min(row[i] + 1, row[i - 1] + 1), diagonal + (a[i - 1] != b[j - 1]));
+            diagonal = up;
+        }
+    }
+    return row[m] <= maxDistance ? row[m] : maxDistance + 1;
+}
+
+class AddressIndex {
+public:
+    struct Match {
+        uint32_t record;
+        int distance;
+    };
+
+private:
+    vector<string> normalized;              // Canonical address per record
+    vector<string> labels;                  // What the record is (contact name, alert ID)
+    unordered_map<uint32_t, vector<uint32_t>> postings; // trigram -> records
+
+    static uint32_t trigram(const string& text, size_t i) {
+        return (uint32_t)(unsigned char)text[i] << 16 | (uint32_t)(unsigned char)text[i + 1] << 8 |
+               (unsigned char)text[i + 2];
+    }
+
+    // Distinct trigrams of the padded text
+    static vector<uint32_t> trigrams(const string& text) {
+        string padded = "  " + text + " ";
+        vector<uint32_t> grams;
+        for (size_t i = 0; i + 3 <= padded.size(); i++) grams.push_back(trigram(padded, i));
+        sort(grams.begin(), grams.end());
+        grams.erase(unique(grams.begin(), grams.end()), grams.end());
+        return grams;
+    }
+
+public:
+    // Lowercase, drop punctuation, expand common abbreviations
+    static string normalize(const string& address) {
+        static const map<string, string> abbreviations = {
+            {"st", "street"}, {"ave", "avenue"}, {"av", "avenue"}, {"rd", "road"},
+            {"blvd", "boulevard"}, {"dr", "drive"}, {"ln", "lane"}, {"ct", "court"},
+            {"pl", "place"}, {"sq", "square"}, {"hwy", "highway"}, {"apt", "apartment"},
+            {"ste", "suite"}, {"fl", "floor"}, {"n", "north"}, {"s", "south"},
+            {"e", "east"}, {"w", "west"}
+        };
+        string result, token;
+        auto flush = [&]() {
+            if (token.empty()) return;
+            auto it = abbreviations.find(token);
+            if (!result.empty()) result += ' ';
+            result += it == abbreviations.end() ? token : it->second;
+            token.clear();
+        };
+        for (unsigned char c : address) {
+            if (isalnum(c)) token += (char)tolower(c);
+            else if (c != '\'') flush(); // "O'Neil" stays one word
+        }
+        flush();
+        return result;
+    }
+
+    uint32_t add(const string& address, const string& label) {
+        uint32_t record = (uint32_t)normalized.size();
+        normalized.push_back(normalize(address));
+        labels.push_back(label);
+        for (uint32_t gram : trigrams(normalized.back())) postings[gram].push_back(record);
+        return record;
+    }
+
+    uint32_t addContact(const Contact& contact) { return add(contact.getAddress(), contact.getName()); }
+
+    // Records within maxDistance edits of the query, closest first. A
+    // record this close must share at least (grams - 3 * maxDistance)
+    // trigrams with the query. That lets the longest posting lists (the
+    // most common trigrams) be skipped, as long as one shared trigram is
+    // still required among the rest; only those candidates are verified.
+    vector<Match> search(const string& address, int maxDistance) const {
+        string query = normalize(address);
+        vector<const vector<uint32_t>*> lists;
+        for (uint32_t gram : trigrams(query)) {
+            auto it = postings.find(gram);
+            if (it != postings.end()) lists.push_back(&it->second);
+        }
+        int needed = (int)trigrams(query).size() - 3 * maxDistance;
+        
+        vector<Match> matches;
+        if (needed < 1) {
+            // Query too short to filter: check every record
+            for (uint32_t record = 0; record < normalized.size(); record++) {
+                int distance = boundedEditDistance(query, normalized[record], maxDistance);
+                if (distance <= maxDistance) matches.push_back({record, distance});
+            }
+        } else {
+            sort(lists.begin(), lists.end(), [](const vector<uint32_t>* x, const vector<uint32_t>* y) {
+                return x->size() < y->size();
+            });
+            int skip = min((int)lists.size(), needed - 1);
+            int threshold = needed - skip;
+            vector<uint16_t> shared(normalized.size(), 0);
+            vector<uint32_t> candidates;
+            for (size_t i = 0; i + skip < lists.size(); i++) {
+                for (uint32_t record : *lists[i]) {
+                    if (++shared[record] == threshold) candidates.push_back(record);
+                }
+            }
+            for (uint32_t record : candidates) {
+                int distance = boundedEditDistance(query, normalized[record], maxDistance);
+                if (distance <= maxDistance) matches.push_back({record, distance});
+            }
+        }
+        sort(matches.begin(), matches.end(), [](const Match& x, const Match& y) {
+            return x.distance != y.distance ? x.distance < y.distance : x.record < y.record;
+        });
+        return matches;
+    }
+
+    const string& getAddress(uint32_t record) const { return normalized[record]; }
+    const string& getLabel(uint32_t record) const { return labels[record]; }
+    size_t size() const { return normalized.size(); }
+};
+
+// ==================== CONTACT SEARCH ====================
+// Path-compressed (radix) trie: each edge carries a run of characters, so
+// long keys with unique tails, like phone numbers, cost one node each.
+class RadixTrie {
+private:
+    struct Node {
+        string label; // Characters on the edge from the parent
+        vector<uint32_t> children;
+        vector<uint32_t> ids;    // Records whose key ends here
+    };
+    vector<Node> nodes;
+    vector<uint32_t> freeNodes;  // Pruned by erase(), reused by insert()
+
+    uint32_t allocate(Node node) {
+        if (freeNodes.empty()) {
+            nodes.push_back(move(node));
+            return (uint32_t)nodes.size() - 1;
+        }
+        uint32_t index = freeNodes.back();
+        freeNodes.pop_back();
+        nodes[index] = move(node);
+        return index;
+    }
+
+    void release(uint32_t node) {
+        nodes[node] = Node();
+        freeNodes.push_back(node);
+    }
+
+    static size_t commonPrefix(const string& a, const string& b, size_t bStart) {
+        size_t n = 0;
+        while (n < a.size() && bStart + n < b.size() && a[n] == b[bStart + n]) n++;
+        return n;
+    }
+
+    int childStartingWith(uint32_t node, char c) const {
+        for (uint32_t child : nodes[node].children) {
+            if (nodes[child].label[0] == c) return (int)child;
+        }
+        return -1;
+    }
+
+    void collect(uint32_t node, size_t limit, vector<uint32_t>& out) const {
+        for (uint32_t id : nodes[node].ids) {
+            if (out.size() >= limit) return;
+            out.push_back(id);
+        }
+        for (uint32_t child : nodes[node].children) {
+            if (out.size() >= limit) return;
+            collect(child, limit, out);
+        }
+    }
+
+    // Levenshtein DP carried down the trie: one row per character. A
+    // branch is abandoned as soon as every cell in its row exceeds k.
+    void fuzzyWalk(uint32_t node, const string& word, vector<int> row, int k,
+                   size_t limit, vector<uint32_t>& out) const {
+        for (char c : nodes[node].label) {
+            vector<int> next(row.size());
+            next[0] = row[0] + 1;
+            for (size_t i = 1; i < row.size(); i++) {
+                next[i] = min(min(next[i - 1] + 1, row[i] + 1), row[i - 1] + (word[i - 1] != c));
+            }
+            row.swap(next);
+            if (*min_element(row.begin(), row.end()) > k) return;
+        }
+        if (row.back() <= k) {
+            for (uint32_t id : nodes[node].ids) {
+                if (out.size() >= limit) return;
+                out.push_back(id);
+            }
+        }
+        for (uint32_t child : nodes[node].children) {
+            if (out.size() >= limit) return;
+            fuzzyWalk(child, word, row, k, limit, out);
+        }
+    }
+
+public:
+    RadixTrie() : nodes(1) {}
+
+    void insert(const string& key, uint32_t id) {
+        uint32_t node = 0;
+        size_t pos = 0;
+        while (pos < key.size()) {
+            int child = childStartingWith(node, key[pos]);
+            if (child < 0) {
+                uint32_t leaf = allocate({key.substr(pos), {}, {id}});
+                nodes[node].children.push_back(leaf);
+                return;
+            }
+            size_t common = commonPrefix(nodes[child].label, key, pos);
+            if (common < nodes[child].label.size()) {
+                // Split the edge: node -> middle -> child
+                uint32_t middle = allocate({nodes[child].label.substr(0, common), {(uint32_t)child}, {}});
+                nodes[child].label.erase(0, common);
+                replace(nodes[node].children.begin(), nodes[node].children.end(), (uint32_t)child, middle);
+                child = (int)middle;
+            }
+            node = (uint32_t)child;
+            pos += common;
+        }
+        nodes[node].ids.push_back(id);
+    }
+
+    // Drops nodes left with no ids and no children, and folds a node left
+    // with only one child into it, so churn does not grow the trie
+    void erase(const string& key, uint32_t id) {
+        vector<uint32_t> path = {0};
+        size_t pos = 0;
+        while (pos < key.size()) {
+            int child = childStartingWith(path.back(), key[pos]);
+            if (child < 0 || commonPrefix(nodes[child].label, key, pos) < nodes[child].label.size()) return;
+            pos += nodes[child].label.size();
+            path.push_back((uint32_t)child);
+        }
+        auto& ids = nodes[path.back()].ids;
+        ids.erase(remove(ids.begin(), ids.end(), id), ids.end());
+        
+        while (path.size() > 1 && nodes[path.back()].ids.empty() && nodes[path.back()].children.empty()) {
+            uint32_t empty = path.back();
+            path.pop_back();
+            auto& siblings = nodes[path.back()].children;
+            siblings.erase(find(siblings.begin(), siblings.end(), empty));
+            release(empty);
+        }
+        uint32_t last = path.back();
+        if (last != 0 && nodes[last].ids.empty() && nodes[last].children.size() == 1) {
+            uint32_t only = nodes[last].children[0];
+            nodes[last].label += nodes[only].label;
+            nodes[last].children = move(nodes[only].children);
+            nodes[last].ids = move(nodes[only].ids);
+            release(only);
+        }
+    }
+
+    // Ids of keys starting with prefix
+    void prefix(const string& key, size_t limit, vector<uint32_t>& out) const {
+        uint32_t node = 0;
+        size_t pos = 0;
+        while (pos < key.size()) {
+            int child = childStartingWith(node, key[pos]);
+            if (child < 0) return;
+            size_t common = commonPrefix(nodes[child].label, key, pos);
+            if (pos + common == key.size()) { // Key ends on (or inside) this edge
+                collect((uint32_t)child, limit, out);
+                return;
+            }
+            if (common < nodes[child].label.size()) return;
+            pos += common;
+            node = (uint32_t)child;
+        }
+        collect(node, limit, out);
+    }
+
+    // Ids of keys within k edits of word
+    void fuzzy(const string& word, int k, size_t limit, vector<uint32_t>& out) const {
+        vector<int> row(word.size() + 1);
+        for (size_t i = 0; i < row.size(); i++) row[i] = (int)i;
+        fuzzyWalk(0, word, row, k, limit, out);
+    }
+
+    size_t nodeCount() const { return nodes.size() - freeNodes.size(); }
+};
+
+// Search over contacts by name, phone and email: prefix search on name
+// words and phone digits, infix search through trigrams, and typo-tolerant
+// name search. Contacts can be added and removed at any time; a removed
+// contact's id (and its storage) is reused by a later add().
+class ContactSearchIndex {
+private:
+    vector<Contact> contacts;
+    vector<bool> live;
+    vector<uint32_t> freeIds;
+    vector<string> searchable; // Lowercased "name phone-digits email"
+    RadixTrie names;           // One key per lowercased name word
+    RadixTrie phones;          // Phone digits only
+    unordered_map<uint32_t, vector<uint32_t>> trigrams; // For infix search
+
+    static string lower(const string& text) {
+        string out;
+        for (unsigned char c : text) out += (char)tolower(c);
+        return out;
+    }
+
+    static string digits(const string& text) {
+        string out;
+        for (char c : text) {
+            if (isdigit((unsigned char)c)) out += c;
+        }
+        return out;
+    }
+
+    static vector<string> words(const string& text) {
+        vector<string> out;
+        string word;
+        for (unsigned char c : text + " ") {
+            if (isalnum(c)) {
+                word += (char)tolower(c);
+            } else if (!word.empty()) {
+                out.push_back(word);
+                word.clear();
+            }
+        }
+        return out;
+    }
+
+    static uint32_t trigramAt(const string& text, size_t i) {
+        return (uint32_t)(unsigned char)text[i] << 16 | (uint32_t)(unsigned char)text[i + 1] << 8 |
+               (unsigned char)text[i + 2];
+    }
+
+    // Keep each contact once, in first-seen order, skipping removed ones
+    vector<uint32_t> unique(const vector<uint32_t>& ids, size_t limit) const {
+        vector<uint32_t> out;
+        unordered_set<uint32_t> seen;
+        for (uint32_t id : ids) {
+            if (out.size() >= limit) break;
+            if (live[id] && seen.insert(id).second) out.push_back(id);
+        }
+        return out;
+    }
+
+public:
+    uint32_t add(const Contact& contact) {
+        string text = lower(contact.getName()) + " " + digits(contact.getPhone()) + " " +
+                      lower(contact.getEmail());
+        uint32_t id;
+        if (freeIds.empty()) {
+            id = (uint32_t)contacts.size();
+            contacts.push_back(contact);
+            live.push_back(true);
+            searchable.push_back(move(text));
+        } else {
+            id = freeIds.back();
+            freeIds.pop_back();
+            contacts[id] = contact;
+            live[id] = true;
+            searchable[id] = move(text);
+        }
+        for (const auto& word : words(contact.getName())) names.insert(word, id);
+        if (!digits(contact.getPhone()).empty()) phones.insert(digits(contact.getPhone()), id);
+        
+        const string& indexed = searchable[id];
+        unordered_set<uint32_t> seen;
+        for (size_t i = 0; i + 3 <= indexed.size(); i++) {
+            uint32_t gram = trigramAt(indexed, i);
+            if (seen.insert(gram).second) trigrams[gram].push_back(id);
+        }
+        return id;
+    }
+
+    bool remove(uint32_t id) {
+        if (id >= contacts.size() || !live[id]) return false;
+        live[id] = false;
+        for (const auto& word : words(contacts[id].getName())) names.erase(word, id);
+        phones.erase(digits(contacts[id].getPhone()), id);
+        
+        const string& text = searchable[id];
+        for (size_t i = 0; i + 3 <= text.size(); i++) {
+            auto postings = trigrams.find(trigramAt(text, i));
+            if (postings == trigrams.end()) continue;
+            auto& ids = postings->second;
+            auto posting = find(ids.begin(), ids.end(), id); // Listed once per gram
+            if (posting == ids.end()) continue;              // Repeated gram, already dropped
+            ids.erase(posting);
+            if (ids.empty()) trigrams.erase(postings);
+        }
+        searchable[id].clear();
+        searchable[id].shrink_to_fit();
+        freeIds.push_back(id);
+        return true;
+    }
+
+    // Name words or phone numbers starting with the query
+    vector<uint32_t> prefixSearch(const string& query, size_t limit = 10) const {
+        vector<uint32_t> found;
+        string queryDigits = digits(query);
+        if (!queryDigits.empty() && queryDigits.size() * 2 >= query.size()) {
+            phones.prefix(queryDigits, limit * 4, found);
+        } else {
+            names.prefix(lower(query), limit * 4, found);
+        }
+        return unique(found, limit);
+    }
+
+    // Query appearing anywhere in the name, phone digits or email
+    vector<uint32_t> infixSearch(const string& query, size_t limit = 10) const {
+        string needle = lower(query);
+        vector<uint32_t> found;
+        if (needle.size() < 3) return found;
+        
+        // Scan the shortest posting list among the query's trigrams
+        const vector<uint32_t>* shortest = nullptr;
+        for (size_t i = 0; i + 3 <= needle.size(); i++) {
+            auto it = trigrams.find(trigramAt(needle, i));
+            if (it == trigrams.end()) return found;
+            if (!shortest || it->second.size() < shortest->size()) shortest = &it->second;
+        }
+        for (uint32_t id : *shortest) {
+            if (found.size() >= limit) break;
+            if (live[id] && searchable[id].find(needle) != string::npos) found.push_back(id);
+        }
+        return found;
+    }
+
+    // Name words within maxEdits typos of the query
+    vector<uint32_t> typoSearch(const string& query, int maxEdits = 1, size_t limit = 10) const {
+        vector<uint32_t> found;
+        names.fuzzy(lower(query), maxEdits, limit * 4, found);
+        return unique(found, limit);
+    }
+
+    const Contact& get(uint32_t id) const { return contacts[id]; }
+    size_t size() const { return contacts.size() - freeIds.size(); }
+};
+
+// ==================== SNAPSHOT ====================
+// Saves users, contacts and the latest status of every alert in one
+// binary file, tagged with the log index it covers. On restart the
+// snapshot is read in one go and only log entries written after it are
+// replayed, instead of rebuilding everything from the text log.
+//
+// File layout (little-endian):
+//   "ESNP", u32 version, u64 log index, u32 users, u32 alert statuses
+//   users:    str id, name, email, phone, password hash; u32 contacts;
+//             each contact: str id, name, phone, email, relation, address; i32 priority
+//   statuses: str alert id, str status
+// where str is a u32 length followed by the bytes.
+class StateSnapshot {
+private:
+    static const uint32_t VERSION = 1;
+
+    static void putLE(string& out, uint64_t value, int bytes) {
+        for (int i = 0; i < bytes; i++) out.push_back((char)(value >> (8 * i)));
+    }
+    static void putStr(string& out, const string& text) {
+        putLE(out, text.size(), 4);
+        out += text;
+    }
+
+    // Bounds-checked reader over the loaded file
+    struct Reader {
+        const char* pos;
+        const char* end;
+
+        bool get(uint64_t& value, int bytes) {
+            if (end - pos < bytes) return false;
+            value = 0;
+            for (int i = 0; i < bytes; i++) value |= (uint64_t)(unsigned char)pos[i] << (8 * i);
+            pos += bytes;
+            return true;
+        }
+        bool str(string& text) {
+            uint64_t length;
+            if (!get(length, 4) || (uint64_t)(end - pos) < length) return false;
+            text.assign(pos, length);
+            pos += length;
+            return true;
+        }
+        // Could `count` records of at least `minBytes` each still follow?
+        bool fits(uint64_t count, uint64_t minBytes) const { return count <= (uint64_t)(end - pos) / minBytes; }
+    };
+    
+    // Smallest encodings: every string empty (u32 length only)
+    static const uint64_t MIN_USER = 5 * 4 + 4;
+    static const uint64_t MIN_CONTACT = 6 * 4 + 4;
+    static const uint64_t MIN_STATUS = 2 * 4;
+
+public:
+    // Encode the state in memory. This is the only step that needs the
+    // state to hold still; writing the bytes out can happen afterwards.
+    static string capture(const vector<User>& users, const map<string, string>& alertStatus, long logIndex) {
+        string out = "ESNP";
+        putLE(out, VERSION, 4);
+        putLE(out, (uint64_t)logIndex, 8);
+        putLE(out, users.size(), 4);
+        putLE(out, alertStatus.size(), 4);
+        for (const auto& user : users) {
+            putStr(out, user.getUserId());
+            putStr(out, user.getName());
+            putStr(out, user.getEmail());
+            putStr(out, user.getPhone());
+            putStr(out, user.getPasswordHash());
+            putLE(out, user.getContacts().size(), 4);
+            for (const auto& contact : user.getContacts()) {
+                putStr(out, contact.getId());
+                putStr(out, contact.getName());
+                putStr(out, contact.getPhone());
+                putStr(out, contact.getEmail());
+                putStr(out, contact.getRelation());
+                putStr(out, contact.getAddress());
+                putLE(out, (uint32_t)contact.getPriority(), 4);
+            }
+        }
+        for (const auto& entry : alertStatus) {
+            putStr(out, entry.first);
+            putStr(out, entry.second);
+        }
+        return out;
+    }
+
+    // Write to a temporary file and rename, so a crash never leaves a
+    // half-written snapshot in place
+    static bool writeFile(const string& filename, const string& bytes) {
+        string temp = filename + ".tmp";
+        {
+            ofstream out(temp, ios::binary | ios::trunc);
+            if (!out.is_open()) {
+                cerr << "Error: Could not open snapshot for writing: " << temp << endl;
+                return false;
+            }
+            out.write(bytes.data(), bytes.size());
+            if (!out.good()) return false;
+        }
+        return rename(temp.c_str(), filename.c_str()) == 0;
+    }
+
+    // Capture now, write on a background thread
+    static future<bool> saveInBackground(const string& filename, const vector<User>& users,
+                                         const map<string, string>& alertStatus, long logIndex) {
+        string bytes = capture(users, alertStatus, logIndex);
+        return async(launch::async, [filename, bytes]() { return writeFile(filename, bytes); });
+    }
+
+    static bool load(const string& filename, vector<User>& users, map<string, string>& alertStatus, long& logIndex) {
+        ifstream in(filename, ios::binary | ios::ate);
+        if (!in.is_open()) {
+            cerr << "Error: Could not open snapshot for reading: " << filename << endl;
+            return false;
+        }
+        streamoff size = in.tellg();
+        if (size < 0) {
+            cerr << "Error: Could not size snapshot: " << filename << endl;
+            return false;
+        }
+        string data((size_t)size, '\0');
+        in.seekg(0);
+        in.read(&data[0], data.size()); // One read of the whole file
+        if (in.gcount() != size) {
+            cerr << "Error: Short read from snapshot: " << filename << endl;
+            return false;
+        }
+        
+        // Decode into locals; the caller's state only changes on success
+        vector<User> loadedUsers;
+        map<string, string> loadedStatus;
+        Reader reader = {data.data(), data.data() + data.size()};
+        uint64_t version, index, userCount, statusCount;
+        if (data.compare(0, 4, "ESNP") != 0) return false;
+        reader.pos += 4;
+        if (!reader.get(version, 4) || version != VERSION) return false;
+        if (!reader.get(index, 8) || !reader.get(userCount, 4) || !reader.get(statusCount, 4)) return false;
+        if (!reader.fits(userCount, MIN_USER)) return false;
+        
+        loadedUsers.reserve(userCount);
+        for (uint64_t u = 0; u < userCount; u++) {
+            string id, name, email, phone, hash;
+            uint64_t contactCount;
+            if (!reader.str(id) || !reader.str(name) || !reader.str(email) || !reader.str(phone) ||
+                !reader.str(hash) || !reader.get(contactCount, 4) || !reader.fits(contactCount, MIN_CONTACT)) {
+                return false;
+            }
+            vector<Contact> contacts;
+            contacts.reserve(contactCount);
+            for (uint64_t c = 0; c < contactCount; c++) {
+                string cid, cname, cphone, cemail, relation, address;
+                uint64_t priority;
+                if (!reader.str(cid) || !reader.str(cname) || !reader.str(cphone) || !reader.str(cemail) ||
+                    !reader.str(relation) || !reader.str(address) || !reader.get(priority, 4)) {
+                    return false;
+                }
+                contacts.push_back(Contact::restore(move(cid), move(cname), move(cphone), move(cemail),
+                                                    move(relation), move(address), (int32_t)priority));
+            }
+            loadedUsers.push_back(User::restore(move(id), move(name), move(email), move(phone), move(hash),
+                                                move(contacts)));
+        }
+        
+        if (!reader.fits(statusCount, MIN_STATUS)) return false;
+        for (uint64_t i = 0; i < statusCount; i++) {
+            string alertId, status;
+            if (!reader.str(alertId) || !reader.str(status)) return false;
+            loadedStatus.emplace_hint(loadedStatus.end(), move(alertId), move(status)); // Saved in key order
+        }
+        users.swap(loadedUsers);
+        alertStatus.swap(loadedStatus);
+        logIndex = (long)index;
+        return true;
+    }
+};
+
+// Startup: load the snapshot, then apply log entries newer than it
+bool restoreState(const string& snapshotFile, const ReplicatedLog& log,
+                  vector<User>& users, map<string, string>& alertStatus) {
+    long snapshotIndex;
+    if (!StateSnapshot::load(snapshotFile, users, alertStatus, snapshotIndex)) return false;
+    long index;
+    string alertId, status;
+    for (const auto& entry : log.entriesAfter(snapshotIndex)) {
+        if (ReplicatedLog::parseEntry(entry, index, alertId, status)) alertStatus[alertId] = status;
+    }
+    return true;
+}
+
+// ==================== INCIDENT FAN-OUT ====================
+// One emergency becomes one Incident. The planner walks the user's
+// contacts once, works out who gets an SMS, an email and a push
+// notification, drops duplicates (the same number or address entered
+// twice in different formats) and applies the user's channel
+// preferences. The incident then creates every channel alert from the
+// same message and location.
+
+// Recipients per channel for one incident
+struct FanOutPlan {
+    vector<string> phones;
+    vector<string> emails;
+    vector<string> deviceTokens;
+    size_t contactsResolved = 0;
+    size_t duplicatesDropped = 0;
+    size_t skippedByPreference = 0;
+};
+
+class Incident {
+private:
+    const string userId;
+    const SharedText message;
+    const SharedLocation location;
+    const FanOutPlan plan;
+
+public:
+    Incident(string uid, SharedText msg, SharedLocation loc, FanOutPlan recipients)
+        : userId(move(uid)), message(move(msg)), location(move(loc)), plan(move(recipients)) {}
+    
+    // Channels createAlerts() can build from a fan-out plan. Authority and
+    // voice alerts need a service or a call list and are raised separately.
+    static const unsigned BUILT_CHANNELS = 1u << CHANNEL_SMS | 1u << CHANNEL_EMAIL | 1u << CHANNEL_PUSH;
+    
+    // Channels in `channels` that createAlerts() will not build
+    static unsigned unbuiltChannels(unsigned channels) { return channels & ~BUILT_CHANNELS; }
+    
+    // One alert per channel that has at least one recipient; `channels`
+    // is a mask of 1 << AlertChannel bits (all channels by default)
+    vector<shared_ptr<Alert>> createAlerts(unsigned channels = ~0u) const {
+        vector<shared_ptr<Alert>> alerts;
+        if (!plan.phones.empty() && (channels & 1u << CHANNEL_SMS)) {
+            alerts.push_back(make_shared<SMSAlert>(userId, message, location, plan.phones));
+        }
+        if (!plan.emails.empty() && (channels & 1u << CHANNEL_EMAIL)) {
+            alerts.push_back(make_shared<EmailAlert>(userId, message, location, plan.emails));
+        }
+        if (!plan.deviceTokens.empty() && (channels & 1u << CHANNEL_PUSH)) {
+            alerts.push_back(make_shared<PushNotificationAlert>(userId, message, location, plan.deviceTokens));
+        }
+        return alerts;
+    }
+    
+    const FanOutPlan& getPlan() const { return plan; }
+    const string& getMessage() const { return *message; }
+    const Location& getLocation() const { return *location; }
+    
+    void displayPlan() const {
+        cout << "Incident plan: " << plan.phones.size() << " SMS, " << plan.emails.size() << " email, "
+             << plan.deviceTokens.size() << " push from " << plan.contactsResolved << " contacts ("
+             << plan.duplicatesDropped << " duplicates dropped, "
+             << plan.skippedByPreference << " skipped by preference)" << endl;
+    }
+};
+
+class FanOutPlanner {
+private:
+    int minPriority[CHANNEL_VOICE + 1];                        // Per channel; lower-priority contacts are skipped
+    unordered_map<string, unsigned> optOuts;                   // Contact ID -> bit per AlertChannel
+    unordered_map<string, vector<string>> devices;             // Contact ID -> push device tokens
+
+    // "+1 (234) 567-8911" and "+12345678911" are the same number
+    static string normalizePhone(const string& phone) {
+        string digits;
+        for (char c : phone) {
+            if (isdigit((unsigned char)c) || (c == '+' && digits.empty())) digits += c;
+        }
+        return digits;
+    }
+    
+    static string normalizeEmail(const string& email) {
+        size_t first = email.find_first_not_of(" \t");
+        size_t last = email.find_last_not_of(" \t");
+        if (first == string::npos) return "";
+        string normalized = email.substr(first, last - first + 1);
+        for (auto& c : normalized) c = (char)tolower((unsigned char)c);
+        return normalized;
+    }
+    
+    bool wants(const Contact& contact, AlertChannel channel) const {
+        if (contact.getPriority() < minPriority[channel]) return false;
+        auto found = optOuts.find(contact.getId());
+        return found == optOuts.end() || !(found->second & (1u << channel));
+    }
+    
+    // Add a recipient unless its normalized form was already taken
+    static void addUnique(vector<string>& recipients, unordered_set<string>& seen,
+                          const string& normalized, FanOutPlan& plan) {
+        if (normalized.empty()) return;
+        if (seen.insert(normalized).second) recipients.push_back(normalized);
+        else plan.duplicatesDropped++;
+    }
+
+public:
+    FanOutPlanner() {
+        for (auto& priority : minPriority) priority = 1;
+    }
+    
+    void setMinPriority(AlertChannel channel, int priority) { minPriority[channel] = priority; }
+    void optOut(const string& contactId, AlertChannel channel) { optOuts[contactId] |= 1u << channel; }
+    void registerDevice(const string& contactId, string token) { devices[contactId].push_back(move(token)); }
+    
+    // Resolve the user's contacts once and build every channel's recipient list
+    FanOutPlan planFor(const User& user) const {
+        FanOutPlan plan;
+        unordered_set<string> seenPhones, seenEmails, seenTokens;
+        for (const auto& contact : user.getContactsByPriority()) {
+            plan.contactsResolved++;
+            bool reached = false;
+            if (wants(contact, CHANNEL_SMS)) {
+                addUnique(plan.phones, seenPhones, normalizePhone(contact.getPhone()), plan);
+                reached = true;
+            }
+            if (wants(contact, CHANNEL_EMAIL)) {
+                addUnique(plan.emails, seenEmails, normalizeEmail(contact.getEmail()), plan);
+                reached = true;
+            }
+            auto registered = devices.find(contact.getId());
+            if (registered != devices.end() && wants(contact, CHANNEL_PUSH)) {
+                for (const auto& token : registered->second) addUnique(plan.deviceTokens, seenTokens, token, plan);
+                reached = true;
+            }
+            if (!reached) plan.skippedByPreference++;
+        }
+        return plan;
+    }
+    
+    Incident open(const User& user, string message, Location location) const {
+        return Incident(user.getUserId(), move(message), move(location), planFor(user));
+    }
+};
+
+// ==================== AREA BROADCAST ====================
+// Wildfires and chemical leaks need the reverse of a personal alert:
+// everyone currently inside an area is notified. Users report their
+// position to a last-known-location store, which keeps a coarse grid of
+// who is in which cell so a broadcast only visits cells overlapping the
+// hazard. Matching users are streamed out as push alerts in paced
+// batches, so the first recipients are reached as soon as the first
+// cells have been scanned.
+
+// ABSTRACTION: The area a hazard covers
+class HazardArea {
+public:
+    virtual ~HazardArea() {}
+    virtual bool contains(double lat, double lng) const = 0;
+    virtual void bounds(double& minLat, double& minLng, double& maxLat, double& maxLng) const = 0;
+};
+
+class CircleArea : public HazardArea {
+private:
+    double centerLat;
+    double centerLng;
+    double radiusMeters;
+
+public:
+    static constexpr double EARTH_RADIUS_METERS = 6371000.0;
+    static constexpr double METERS_PER_DEGREE = 111320.0;
+
+    CircleArea(double lat, double lng, double radius) : centerLat(lat), centerLng(lng), radiusMeters(radius) {}
+    
+    // Great-circle (haversine) distance from the center
+    bool contains(double lat, double lng) const override {
+        const double toRad = 3.14159265358979323846 / 180.0;
+        double dLat = (lat - centerLat) * toRad;
+        double dLng = (lng - centerLng) * toRad;
+        double h = sin(dLat / 2) * sin(dLat / 2) +
+                   cos(centerLat * toRad) * cos(lat * toRad) * sin(dLng / 2) * sin(dLng / 2);
+        return 2 * EARTH_RADIUS_METERS * asin(min(1.0, sqrt(h))) <= radiusMeters;
+    }
+    
+    void bounds(double& minLat, double& minLng, double& maxLat, double& maxLng) const override {
+        double latSpan = radiusMeters / METERS_PER_DEGREE;
+        double lngSpan = latSpan / max(0.01, cos(centerLat * 3.14159265358979323846 / 180.0));
+        minLat = centerLat - latSpan;
+        maxLat = centerLat + latSpan;
+        minLng = centerLng - lngSpan;
+        maxLng = centerLng + lngSpan;
+    }
+};
+
+class PolygonArea : public HazardArea {
+private:
+    vector<pair<double, double>> vertices; // (lat, lng) in order around the edge
+
+public:
+    PolygonArea(vector<pair<double, double>> points) : vertices(move(points)) {}
+    
+    // Even-odd rule: count edges crossed by a ray heading east
+    bool contains(double lat, double lng) const override {
+        bool inside = false;
+        for (size_t i = 0, j = vertices.size() - 1; i < vertices.size(); j = i++) {
+            double latI = vertices[i].first, lngI = vertices[i].second;
+            double latJ = vertices[j].first, lngJ = vertices[j].second;
+            if ((latI > lat) != (latJ > lat) &&
+                lng < (lngJ - lngI) * (lat - latI) / (latJ - latI) + lngI) {
+                inside = !inside;
+            }
+        }
+        return inside;
+    }
+    
+    void bounds(double& minLat, double& minLng, double& maxLat, double& maxLng) const override {
+        minLat = minLng = 1e9;
+        maxLat = maxLng = -1e9;
+        for (const auto& vertex : vertices) {
+            minLat = min(minLat, vertex.first);
+            maxLat = max(maxLat, vertex.first);
+            minLng = min(minLng, vertex.second);
+            maxLng = max(maxLng, vertex.second);
+        }
+    }
+};
+
+// Latest reported position of every registered user. Each user has one
+// fixed-size record holding the position quantized to 1e-7 degrees
+// (about 1 cm), the report time and its accuracy. Records are guarded by
+// a sequence lock: a writer makes the sequence odd while it writes and
+// even again when done, and a reader retries if the sequence was odd or
+// changed under it. Readers therefore never block or write shared
+// memory, and a writer only waits if another writer has the same user.
+//
+// Users are split into contiguous shards, so one shard's records sit
+// together in memory. Each shard also keeps a coarse grid of cell ->
+// members. A report only touches the grid when the user crosses into
+// another cell, and does so after releasing the record: under the
+// shard's lock it re-reads the record and files the user under the cell
+// of whatever position is newest, so racing writers still converge.
+class LocationStore {
+public:
+    static const int32_t E7 = 10000000;            // Quantization: 1e-7 degrees
+    static const int32_t CELL_E7 = 100000;         // Cell size 0.01 degrees, about 1.1 km north-south
+    static constexpr double CELL_DEGREES = 0.01;
+
+    struct Position {
+        double latitude;
+        double longitude;
+        time_t updated;
+        uint32_t accuracyMeters;
+    };
+
+    static int32_t quantize(double degrees) { return (int32_t)llround(degrees * E7); }
+    static int32_t cellOf(int32_t e7) { return e7 >= 0 ? e7 / CELL_E7 : -((-(int64_t)e7 + CELL_E7 - 1) / CELL_E7); }
+    static int32_t cellRow(double lat) { return cellOf(quantize(lat)); }
+    static int32_t cellCol(double lng) { return cellOf(quantize(lng)); }
+    static uint64_t cellKey(int32_t row, int32_t col) { return (uint64_t)(uint32_t)row << 32 | (uint32_t)col; }
+
+private:
+    static const uint32_t SHARDS = 16;
+
+    // Fields are atomics so the racing reads a seqlock relies on are well
+    // defined. Writers store them with release and readers load them with
+    // acquire, which orders them against the sequence without fences.
+    struct PositionRecord {
+        atomic<uint32_t> sequence;       // Odd while a write is in progress
+        atomic<int32_t> latitudeE7;
+        atomic<int32_t> longitudeE7;
+        atomic<uint32_t> accuracyMeters;
+        atomic<int64_t> updated;
+        atomic<uint32_t> known;          // 0 until the first report
+        char reserved[4];
+    };
+    static_assert(sizeof(PositionRecord) == 32, "two position records per cache line");
+
+    struct Shard {
+        mutable mutex gridLock;
+        unordered_map<uint64_t, vector<uint32_t>> cells; // Cell -> user indexes
+        vector<uint64_t> filedCell;                       // Cell each user is filed under, by local index
+        vector<uint32_t> cellSlot;                        // Position in that cell's member list
+        vector<bool> filed;                               // In the grid at all
+    };
+
+    const uint32_t capacity;
+    const uint32_t usersPerShard;
+    unique_ptr<char[]> storage;          // Records start on a cache line boundary inside this
+    PositionRecord* records;
+    Shard shards[SHARDS];
+    vector<string> userIds;              // Written once at registration
+    mutex registryLock;
+    unordered_map<string, uint32_t> indexByUser;
+    atomic<uint32_t> registered;         // Indexes below this are valid
+
+    // File the user under the cell of its newest position
+    void refileUser(uint32_t user) {
+        Position position;
+        Shard& shard = shards[user / usersPerShard];
+        uint32_t local = user % usersPerShard;
+        lock_guard<mutex> guard(shard.gridLock);
+        if (!read(user, position)) return;
+        uint64_t to = cellKey(cellRow(position.latitude), cellCol(position.longitude));
+        if (shard.filed[local]) {
+            if (shard.filedCell[local] == to) return; // Another writer already moved it
+            auto cell = shard.cells.find(shard.filedCell[local]);
+            vector<uint32_t>& members = cell->second;
+            uint32_t slot = shard.cellSlot[local];
+            uint32_t moved = members.back(); // Swap-remove; fix up the member that moved
+            members[slot] = moved;
+            shard.cellSlot[moved % usersPerShard] = slot;
+            members.pop_back();
+            if (members.empty()) shard.cells.erase(cell);
+        }
+        vector<uint32_t>& members = shard.cells[to];
+        shard.filed[local] = true;
+        shard.filedCell[local] = to;
+        shard.cellSlot[local] = (uint32_t)members.size();
+        members.push_back(user);
+    }
+
+public:
+    LocationStore(uint32_t maxUsers)
+        : capacity(maxUsers), usersPerShard((maxUsers + SHARDS - 1) / SHARDS),
+          storage(new char[maxUsers * sizeof(PositionRecord) + 64]), userIds(maxUsers), registered(0) {
+        records = reinterpret_cast<PositionRecord*>(((uintptr_t)storage.get() + 63) & ~(uintptr_t)63);
+        for (uint32_t i = 0; i < capacity; i++) {
+            new (&records[i]) PositionRecord();
+            records[i].sequence.store(0, memory_order_relaxed);
+            records[i].latitudeE7.store(0, memory_order_relaxed);
+            records[i].longitudeE7.store(0, memory_order_relaxed);
+            records[i].accuracyMeters.store(0, memory_order_relaxed);
+            records[i].updated.store(0, memory_order_relaxed);
+            records[i].known.store(0, memory_order_relaxed);
+        }
+        for (auto& shard : shards) {
+            shard.filedCell.resize(usersPerShard);
+            shard.cellSlot.resize(usersPerShard);
+            shard.filed.resize(usersPerShard);
+        }
+    }
+    
+    // Sets index (to pass to update()); registering twice gives the same
+    // index. False when the store is full.
+    bool registerUser(const string& userId, uint32_t& index) {
+        lock_guard<mutex> guard(registryLock);
+        auto found = indexByUser.find(userId);
+        if (found != indexByUser.end()) {
+            index = found->second;
+            return true;
+        }
+        if (indexByUser.size() >= capacity) {
+            cerr << "Error: Location store is full, cannot register " << userId << endl;
+            return false;
+        }
+        index = (uint32_t)indexByUser.size();
+        indexByUser.emplace(userId, index);
+        userIds[index] = userId;
+        registered.store(index + 1, memory_order_release);
+        return true;
+    }
+    
+    // False for an unregistered index or a position off the globe
+    bool update(uint32_t user, double lat, double lng, time_t when, uint32_t accuracyMeters = 0) {
+        if (user >= registered.load(memory_order_acquire)) {
+            cerr << "Error: Position update for unregistered user index " << user << endl;
+            return false;
+        }
+        if (!(lat >= -90.0 && lat <= 90.0 && lng >= -180.0 && lng <= 180.0)) return false;
+        PositionRecord& record = records[user];
+        int32_t latE7 = quantize(lat), lngE7 = quantize(lng);
+        
+        // Take the record: wait out another writer, then make the sequence odd
+        uint32_t seq = record.sequence.load(memory_order_relaxed);
+        for (;;) {
+            if (seq & 1) {
+                seq = record.sequence.load(memory_order_relaxed);
+                continue;
+            }
+            if (record.sequence.compare_exchange_weak(seq, seq + 1, memory_order_acquire, memory_order_relaxed)) break;
+        }
+        
+        bool known = record.known.load(memory_order_relaxed) != 0;
+        bool sameCell = cellOf(record.latitudeE7.load(memory_order_relaxed)) == cellOf(latE7) &&
+                        cellOf(record.longitudeE7.load(memory_order_relaxed)) == cellOf(lngE7);
+        record.latitudeE7.store(latE7, memory_order_release);
+        record.longitudeE7.store(lngE7, memory_order_release);
+        record.accuracyMeters.store(accuracyMeters, memory_order_release);
+        record.updated.store(when, memory_order_release);
+        record.known.store(1, memory_order_release);
+        record.sequence.store(seq + 2, memory_order_release);
+        
+        // Grid work happens with the record released, so readers never
+        // spin while a writer waits for the shard lock
+        if (!known || !sameCell) refileUser(user);
+        return true;
+    }
+    
+    // Lock-free read; false if the user has never reported a position
+    bool read(uint32_t user, Position& out) const {
+        if (user >= registered.load(memory_order_acquire)) return false;
+        const PositionRecord& record = records[user];
+        int32_t latE7, lngE7;
+        uint32_t accuracy, known;
+        int64_t updated;
+        for (;;) {
+            uint32_t before = record.sequence.load(memory_order_acquire);
+            if (before & 1) continue;
+            latE7 = record.latitudeE7.load(memory_order_acquire);
+            lngE7 = record.longitudeE7.load(memory_order_acquire);
+            accuracy = record.accuracyMeters.load(memory_order_acquire);
+            updated = record.updated.load(memory_order_acquire);
+            known = record.known.load(memory_order_acquire);
+            if (record.sequence.load(memory_order_relaxed) == before) break;
+        }
+        if (!known) return false;
+        out.latitude = (double)latE7 / E7;
+        out.longitude = (double)lngE7 / E7;
+        out.updated = (time_t)updated;
+        out.accuracyMeters = accuracy;
+        return true;
+    }
+    
+    // Calls visit(userId, lat, lng) for every user last seen in the cell.
+    // Holds each shard's grid lock only to copy the member list.
+    void forEachInCell(int32_t row, int32_t col,
+                       const function<void(const string&, double, double)>& visit) const {
+        uint64_t cell = cellKey(row, col);
+        vector<uint32_t> members;
+        Position position;
+        for (const auto& shard : shards) {
+            {
+                lock_guard<mutex> guard(shard.gridLock);
+                auto found = shard.cells.find(cell);
+                if (found == shard.cells.end()) continue;
+                members = found->second;
+            }
+            for (uint32_t user : members) {
+                if (read(user, position)) visit(userIds[user], position.latitude, position.longitude);
+            }
+        }
+    }
+    
+    size_t userCount() {
+        lock_guard<mutex> guard(registryLock);
+        return indexByUser.size();
+    }
+};
+
+struct BroadcastStats {
+    size_t cellsVisited = 0;
+    size_t candidates = 0;    // Users in visited cells
+    size_t recipients = 0;    // Users inside the area
+    size_t batches = 0;
+    double firstBatchMs = 0;
+    double totalMs = 0;
+};
+
+class AreaBroadcaster {
+public:
+    typedef function<void(unique_ptr<PushNotificationAlert>)> Dispatch;
+
+private:
+    const LocationStore& store;
+    size_t batchSize;
+    double batchesPerSecond; // Pacing so downstream gateways are not flooded
+
+public:
+    AreaBroadcaster(const LocationStore& locations, size_t perBatch, double rate)
+        : store(locations), batchSize(perBatch), batchesPerSecond(rate) {}
+    
+    // Push recipients are user IDs; the push service resolves their devices
+    BroadcastStats broadcast(const string& sourceId, const HazardArea& area, SharedText message,
+                             SharedLocation origin, const Dispatch& dispatch) const {
+        BroadcastStats stats;
+        auto start = chrono::steady_clock::now();
+        vector<string> batch;
+        batch.reserve(batchSize);
+        
+        auto flush = [&]() {
+            if (batch.empty()) return;
+            auto due = start + chrono::duration_cast<chrono::steady_clock::duration>(
+                chrono::duration<double>(stats.batches / batchesPerSecond));
+            this_thread::sleep_until(due);
+            dispatch(unique_ptr<PushNotificationAlert>(
+                new PushNotificationAlert(sourceId, message, origin, move(batch))));
+            batch.clear();
+            if (stats.batches++ == 0) {
+                stats.firstBatchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            }
+        };
+        
+        double minLat, minLng, maxLat, maxLng;
+        area.bounds(minLat, minLng, maxLat, maxLng);
+        for (int32_t row = LocationStore::cellRow(minLat); row <= LocationStore::cellRow(maxLat); row++) {
+            for (int32_t col = LocationStore::cellCol(minLng); col <= LocationStore::cellCol(maxLng); col++) {
+                stats.cellsVisited++;
+                store.forEachInCell(row, col, [&](const string& userId, double lat, double lng) {
+                    stats.candidates++;
+                    if (!area.contains(lat, lng)) return;
+                    stats.recipients++;
+                    batch.push_back(userId);
+                });
+                if (batch.size() >= batchSize) flush(); // Cells are small, so batches overshoot little
+            }
+        }
+        flush();
+        stats.totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        return stats;
+    }
+};
+
+// ==================== ROUTING RULES ====================
+// Which channels fire for an emergency is decided by rules in a config
+// file instead of by code. One rule per line:
+//
+//   when type=medical and severity>=4 -> +sms +voice +authority
+//   when type=general -> =push
+//   when hour>=22 or hour<6 -> -email
+//   always -> +sms
+//
+// Conditions compare type (= or !=), severity or hour (=, !=, <, <=, >,
+// >=); "and" binds tighter than "or". Actions add (+), remove (-) or
+// replace the set with (=) a channel: sms, email, authority, push, voice.
+// Every matching rule is applied in file order, starting from no channels.
+//
+// Rules are compiled into a flat array of tests with jump targets, so
+// evaluation is a short loop over small structs with no string work.
+// A reload builds a complete new rule set and swaps it in atomically;
+// dispatch threads keep using the old set until their next lookup.
+
+// Channel set as a bit mask, one bit per AlertChannel
+inline unsigned channelBit(AlertChannel channel) { return 1u << channel; }
+
+// Local time without localtime()'s shared buffer, which dispatch
+// threads building contexts concurrently would overwrite
+inline tm localTime(time_t when) {
+    tm local;
+#if defined(_WIN32)
+    localtime_s(&local, &when);
+#else
+    localtime_r(&when, &local);
+#endif
+    return local;
+}
+
+// What the rules are evaluated against
+struct RoutingContext {
+    size_t typeKey;   // hash of the incident type ("medical", "fire", ...)
+    int severity;     // 1-5
+    int hour;         // 0-23, local time
+
+    static RoutingContext make(const string& type, int severity, time_t when) {
+        return {hash<string>()(type), severity, localTime(when).tm_hour};
+    }
+};
+
+class RuleSet {
+private:
+    enum Field : uint8_t { FIELD_TYPE, FIELD_SEVERITY, FIELD_HOUR };
+    enum Op : uint8_t { OP_EQ, OP_NE, OP_LT, OP_LE, OP_GT, OP_GE };
+
+    struct Test {
+        Field field;
+        Op op;
+        bool endsClause;     // Last test of an "and" group: passing it matches the rule
+        uint16_t nextClause; // Where to continue when the test fails
+        int64_t value;       // Number, or hash of the type name
+    };
+    struct Rule {
+        uint16_t first, end; // Tests [first, end); empty means always
+        unsigned clear;      // Channels removed, then
+        unsigned set;        // channels added
+    };
+    vector<Test> tests;
+    vector<Rule> rules;
+
+    static bool parseChannel(const string& name, unsigned& bit) {
+        static const map<string, AlertChannel> channels = {
+            {"sms", CHANNEL_SMS}, {"email", CHANNEL_EMAIL}, {"authority", CHANNEL_AUTHORITY},
+            {"push", CHANNEL_PUSH}, {"voice", CHANNEL_VOICE}
+        };
+        auto found = channels.find(name);
+        if (found == channels.end()) return false;
+        bit = channelBit(found->second);
+        return true;
+    }
+    
+    // "severity>=4" -> test; nextClause is patched once the clause ends
+    static bool parseTest(const string& token, Test& test) {
+        size_t opStart = token.find_first_of("=!<>");
+        if (opStart == string::npos || opStart == 0) return false;
+        size_t valueStart = token.find_first_not_of("=!<>", opStart);
+        if (valueStart == string::npos) return false;
+        string field = token.substr(0, opStart);
+        string op = token.substr(opStart, valueStart - opStart);
+        string value = token.substr(valueStart);
+        
+        static const map<string, Op> ops = {
+            {"=", OP_EQ}, {"==", OP_EQ}, {"!=", OP_NE}, {"<", OP_LT}, {"<=", OP_LE}, {">", OP_GT}, {">=", OP_GE}
+        };
+        auto found = ops.find(op);
+        if (found == ops.end()) return false;
+        test.op = found->second;
+        test.endsClause = false;
+        test.nextClause = 0;
+        if (field == "type") {
+            if (test.op != OP_EQ && test.op != OP_NE) return false;
+            test.field = FIELD_TYPE;
+            test.value = (int64_t)hash<string>()(value);
+            return true;
+        }
+        if (field != "severity" && field != "hour") return false;
+        test.field = field == "severity" ? FIELD_SEVERITY : FIELD_HOUR;
+        char* end;
+        test.value = strtol(value.c_str(), &end, 10);
+        return *end == '\0';
+    }
+    
+    // Parse "when ... -> actions" or "always -> actions"
+    bool compileLine(const string& line, string& error) {
+        if (tests.size() > 60000) { // Jump targets are 16-bit
+            error = "too many conditions";
+            return false;
+        }
+        size_t arrow = line.find("->");
+        if (arrow == string::npos) {
+            error = "missing '->'";
+            return false;
+        }
+        istringstream condition(line.substr(0, arrow));
+        istringstream actions(line.substr(arrow + 2));
+        
+        Rule rule = {(uint16_t)tests.size(), 0, 0, 0};
+        string word;
+        condition >> word;
+        if (word == "when") {
+            size_t clauseStart = tests.size();
+            bool expectTest = true;
+            while (condition >> word) {
+                if (!expectTest && (word == "and" || word == "or")) {
+                    if (word == "or") {
+                        tests.back().endsClause = true;
+                        for (size_t i = clauseStart; i < tests.size(); i++) tests[i].nextClause = (uint16_t)tests.size();
+                        clauseStart = tests.size();
+                    }
+                    expectTest = true;
+                    continue;
+                }
+                Test test;
+                if (!expectTest || !parseTest(word, test)) {
+                    error = "bad condition '" + word + "'";
+                    return false;
+                }
+                tests.push_back(test);
+                expectTest = false;
+            }
+            if (expectTest) {
+                error = "condition is incomplete";
+                return false;
+            }
+            tests.back().endsClause = true;
+            for (size_t i = clauseStart; i < tests.size(); i++) tests[i].nextClause = (uint16_t)tests.size();
+        } else if (word != "always" || (condition >> word)) {
+            error = "expected 'when' or 'always'";
+            return false;
+        }
+        rule.end = (uint16_t)tests.size();
+        
+        bool any = false;
+        while (actions >> word) {
+            unsigned bit;
+            if (word.size() < 2 || !parseChannel(word.substr(1), bit)) {
+                error = "bad action '" + word + "'";
+                return false;
+            }
+            if (word[0] == '+') {
+                rule.set |= bit;
+                rule.clear &= ~bit;
+            } else if (word[0] == '-') {
+                rule.clear |= bit;
+                rule.set &= ~bit;
+            } else if (word[0] == '=') {
+                rule.clear = ~0u;
+                rule.set = bit;
+            } else {
+                error = "bad action '" + word + "'";
+                return false;
+            }
+            any = true;
+        }
+        if (!any) {
+            error = "no actions";
+            return false;
+        }
+        rules.push_back(rule);
+        return true;
+    }
+    
+    bool passes(const Test& test, const RoutingContext& context) const {
+        int64_t actual = test.field == FIELD_TYPE ? (int64_t)context.typeKey
+                       : test.field == FIELD_SEVERITY ? context.severity : context.hour;
+        switch (test.op) {
+            case OP_EQ: return actual == test.value;
+            case OP_NE: return actual != test.value;
+            case OP_LT: return actual < test.value;
+            case OP_LE: return actual <= test.value;
+            case OP_GT: return actual > test.value;
+            case OP_GE: return actual >= test.value;
+        }
+        return false;
+    }
+    
+    bool matches(const Rule& rule, const RoutingContext& context) const {
+        if (rule.first == rule.end) return true;
+        uint16_t pc = rule.first;
+        while (pc < rule.end) {
+            const Test& test = tests[pc];
+            if (passes(test, context)) {
+                if (test.endsClause) return true;
+                pc++;
+            } else {
+                pc = test.nextClause;
+            }
+        }
+        return false;
+    }
+
+public:
+    // Compile rules from a file; on error nothing is returned and the
+    // caller keeps whatever rules it had
+    static shared_ptr<const RuleSet> load(const string& filename) {
+        ifstream in(filename);
+        if (!in.is_open()) {
+            cerr << "Error: Could not open routing rules: " << filename << endl;
+            return nullptr;
+        }
+        shared_ptr<RuleSet> compiled = make_shared<RuleSet>();
+        string line, error;
+        for (int number = 1; getline(in, line); number++) {
+            size_t comment = line.find('#');
+            if (comment != string::npos) line.erase(comment);
+            if (line.find_first_not_of(" \t\r") == string::npos) continue;
+            if (!compiled->compileLine(line, error)) {
+                cerr << "Error: " << filename << ":" << number << ": " << error << endl;
+                return nullptr;
+            }
+        }
+        return compiled;
+    }
+    
+    unsigned evaluate(const RoutingContext& context) const {
+        unsigned channels = 0;
+        for (const auto& rule : rules) {
+            if (matches(rule, context)) channels = (channels & ~rule.clear) | rule.set;
+        }
+        return channels;
+    }
+    
+    size_t ruleCount() const { return rules.size(); }
+};
+
+// Holds the live rule set; reload() swaps it without stopping routing
+class RoutingEngine {
+private:
+    shared_ptr<const RuleSet> rules;
+
+public:
+    RoutingEngine() : rules(make_shared<RuleSet>()) {}
+    
+    bool reload(const string& filename) {
+        shared_ptr<const RuleSet> compiled = RuleSet::load(filename);
+        if (!compiled) return false;
+        atomic_store(&rules, compiled);
+        return true;
+    }
+    
+    // Hot loops can take the rule set once and evaluate many alerts with it
+    shared_ptr<const RuleSet> current() const { return atomic_load(&rules); }
+    
+    unsigned route(const RoutingContext& context) const { return current()->evaluate(context); }
+    
+    static string describe(unsigned channels) {
+        static const char* names[] = {"", "SMS", "Email", "Authority", "Push", "Voice"};
+        string text;
+        for (int channel = CHANNEL_SMS; channel <= CHANNEL_VOICE; channel++) {
+            if (!(channels & (1u << channel))) continue;
+            if (!text.empty()) text += "+";
+            text += names[channel];
+        }
+        return text.empty() ? "none" : text;
+    }
+};
+
+// ==================== DEMONSTRATION OF POLYMORPHISM ====================
+void demonstratePolymorphism(vector<shared_ptr<Alert>>& alerts, AlertFeed* feed = nullptr) {
+    cout << "\n\n========== DEMONSTRATING POLYMORPHISM ==========" << endl;
+    cout << "Sending different types of alerts using same interface..." << endl;
+    
+    // POLYMORPHISM: Calling the same method on different object types
+    for (auto& alert : alerts) {
+        alert->sendAlert(); // Different behavior based on actual object type
+        cout << alert->getAlertDetails() << endl;
+        if (feed) feed->publish("status", *alert);
+    }
+}
+
+// ==================== MAIN FUNCTION ====================
+int main() {
+    cout << "╔════════════════════════════════════════════════════════╗" << endl;
+    cout << "║   EMERGENCY CONTACT SYSTEM - OOP IMPLEMENTATION        ║" << endl;
+    cout << "║   Demonstrating: Classes, Encapsulation, Abstraction,  ║" << endl;
+    cout << "║   Inheritance, Polymorphism, and File Handling         ║" << endl;
     cout << "╚════════════════════════════════════════════════════════╝" << endl;
     
     // CLASS & OBJECT: Creating user object
@@ -394,9 +4463,9 @@ int main() {
     user.displayProfile();
     
     // Creating contact objects
-    Contact contact1("Jane Doe", "+1234567891", "jane@email.com", "Sister", "123 Main St");
-    Contact contact2("Dr. Smith", "+1234567892", "dr.smith@hospital.com", "Doctor", "Hospital Ave");
-    Contact contact3("Mom", "+1234567893", "mom@email.com", "Mother", "456 Oak St");
+    Contact contact1("Jane Doe", "+1234567891", "jane@email.com", "Sister", "123 Main St", 2);
+    Contact contact2("Dr. Smith", "+1234567892", "dr.smith@hospital.com", "Doctor", "Hospital Ave", 1);
+    Contact contact3("Mom", "+1234567893", "mom@email.com", "Mother", "456 Oak St", 3);
     
     user.addContact(contact1);
     user.addContact(contact2);
@@ -416,19 +4485,16 @@ int main() {
     // Creating different types of alerts (all inherit from Alert base class)
     vector<shared_ptr<Alert>> alerts;
     
-    alerts.push_back(make_shared<SMSAlert>(
-        user.getUserId(),
-        "EMERGENCY! I need help at Times Square!",
-        emergencyLocation,
-        vector<string>{"+1234567891", "+1234567893"}
-    ));
-    
-    alerts.push_back(make_shared<EmailAlert>(
-        user.getUserId(),
-        "URGENT: Emergency situation. Please check your phone!",
-        emergencyLocation,
-        vector<string>{"jane@email.com", "mom@email.com"}
-    ));
+    // SMS, email and push recipients come from the user's contacts: family
+    // (priority 2+) get texts and emails, and push goes to their devices
+    FanOutPlanner planner;
+    planner.setMinPriority(CHANNEL_SMS, 2);
+    planner.setMinPriority(CHANNEL_EMAIL, 2);
+    planner.registerDevice(contact1.getId(), "token_abc123");
+    planner.registerDevice(contact3.getId(), "token_def456");
+    Incident incident = planner.open(user, "EMERGENCY! I need help at Times Square!", emergencyLocation);
+    incident.displayPlan();
+    alerts = incident.createAlerts();
     
     alerts.push_back(make_shared<AuthorityAlert>(
         user.getUserId(),
@@ -437,16 +4503,36 @@ int main() {
         "medical"
     ));
     
-    alerts.push_back(make_shared<PushNotificationAlert>(
+    // Highest severity: call relatives until one of them answers
+    TelephonyGateway gateway;
+    gateway.addTrunk("trunk-a", 4);
+    gateway.addTrunk("trunk-b", 4);
+    alerts.push_back(make_shared<VoiceCallAlert>(
         user.getUserId(),
-        "Emergency alert triggered! Tap to view details.",
+        "This is an emergency call for John Doe. Please call back immediately.",
         emergencyLocation,
-        vector<string>{"token_abc123", "token_def456"}
+        user.getContactsByPriority(),
+        gateway
     ));
     
+    // Responder dashboards subscribe to the live feed by region and type
+    AlertFeed feed;
+    auto cityDashboard = feed.subscribe("NYC-Dispatch", FeedFilter(40.4, -74.3, 41.0, -73.6));
+    auto medicalDashboard = feed.subscribe("EMS-Medical", FeedFilter(-90.0, -180.0, 90.0, 180.0, "Authority"));
+    for (const auto& alert : alerts) {
+        feed.publish("created", *alert);
+    }
+    
     // POLYMORPHISM: Demonstrating method overriding
     cout << "\n\n========== 4. POLYMORPHISM DEMONSTRATION ==========" << endl;
-    demonstratePolymorphism(alerts);
+    demonstratePolymorphism(alerts, &feed);
+    
+    cout << "\nAlerts sent per channel:";
+    for (int channel = CHANNEL_SMS; channel < CHANNEL_COUNT; channel++) {
+        cout << (channel == CHANNEL_SMS ? " " : ", ") << channelName((AlertChannel)channel) << "="
+             << Alert::sentCount((AlertChannel)channel);
+    }
+    cout << endl;
     
     // Display all alert summaries
     cout << "\n\n========== ALERT SUMMARIES ==========" << endl;
@@ -466,6 +4552,663 @@ int main() {
     // Read logs from file
     fileHandler.readEmergencyLogs();
     
+    // Keep a replicated copy of the log so one lost file loses nothing
+    ReplicatedLog replicatedLog({"emergency_logs.r0.txt", "emergency_logs.r1.txt", "emergency_logs.r2.txt"});
+    replicatedLog.appendBatch(alerts);
+    replicatedLog.failReplica(0);
+    replicatedLog.appendBatch(alerts);
+    replicatedLog.recoverReplica(0);
+    
+    // LIVE FEED: Deliver queued events to the dashboards
+    cout << "\n\n========== 6. LIVE ALERT FEED ==========" << endl;
+    cout << "Subscribers: " << feed.subscriberCount() << endl;
+    cityDashboard->flush();
+    medicalDashboard->flush();
+    
+    // SHARDING: Spread users over nodes and route triggers to the owner
+    cout << "\n\n========== 7. SHARDING ==========" << endl;
+    ShardedDirectory directory;
+    directory.addNode("node-1");
+    directory.addNode("node-2");
+    directory.addNode("node-3");
+    directory.addUser(user);
+    int deploymentCost = PasswordHasher::getDefaultCost();
+    PasswordHasher::setDefaultCost(PasswordHasher::MIN_COST); // Synthetic users: cheap hashes
+    for (int i = 0; i < 300; i++) {
+        directory.addUser(User("User " + to_string(i), "user" + to_string(i) + "@email.com",
+                               "+1555000" + to_string(i), "pass" + to_string(i)));
+    }
+    PasswordHasher::setDefaultCost(deploymentCost);
+    directory.displayShards();
+    cout << "Alert from " << user.getName() << " routed to: " << directory.routeAlert(*alerts[0]) << endl;
+    directory.addNode("node-4");
+    directory.removeNode("node-2");
+    directory.displayShards();
+    
+    // BINARY PROTOCOL: Partner pushes pipelined batches of triggers
+    cout << "\n\n========== 8. BINARY ALERT PROTOCOL ==========" << endl;
+    vector<AlertTrigger> partnerBatch = {
+        {CHANNEL_SMS, user.getUserId(), "Panic button pressed", emergencyLocation, {"+1234567891"}},
+        {CHANNEL_AUTHORITY, user.getUserId(), "Fall detected by wearable", emergencyLocation, {"medical"}}
+    };
+    string stream;
+    FrameCodec::encodeBatch(stream, 1, partnerBatch);
+    FrameCodec::encodeBatch(stream, 2, partnerBatch);
+    
+    // Feed the stream in small chunks, as a socket read would deliver it
+    FrameDecoder decoder;
+    vector<DecodedFrame> received;
+    for (size_t offset = 0; offset < stream.size(); offset += 7) {
+        decoder.feed(stream.data() + offset, min<size_t>(7, stream.size() - offset), received);
+    }
+    cout << "Decoded " << received.size() << " frames from " << stream.size() << " bytes" << endl;
+    for (const auto& frame : received) {
+        cout << "  Request " << frame.requestId << ": " << frame.triggers.size() << " triggers" << endl;
+        for (const auto& trigger : frame.triggers) {
+            cout << "  → " << createAlert(trigger)->getAlertDetails() << endl;
+        }
+    }
+    
+    // Ingestion benchmark: decode many batches of 1000 triggers
+    vector<AlertTrigger> bulk(1000, partnerBatch[0]);
+    string bulkStream;
+    for (uint32_t i = 0; i < 100; i++) FrameCodec::encodeBatch(bulkStream, i, bulk);
+    FrameDecoder bulkDecoder;
+    vector<DecodedFrame> bulkReceived;
+    auto start = chrono::steady_clock::now();
+    bulkDecoder.feed(bulkStream.data(), bulkStream.size(), bulkReceived);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    size_t bulkTriggers = 0;
+    for (const auto& frame : bulkReceived) bulkTriggers += frame.triggers.size();
+    cout << "Decoded " << bulkTriggers << " triggers in " << seconds * 1000 << " ms ("
+         << (long)(bulkTriggers / seconds) << " triggers/sec)" << endl;
+    
+    // VOICE CALLS: Many cascades competing for a few call slots
+    cout << "\n\n========== 9. VOICE CALL LOAD TEST ==========" << endl;
+    simulateCallLoad(gateway, 500, 3);
+    
+    // CASCADE: Notify contacts tier by tier until someone acknowledges
+    cout << "\n\n========== 10. PRIORITY CASCADE ==========" << endl;
+    CascadeEngine cascadeEngine(60, [](const string& alertId, const string& message, const vector<Contact>& tier) {
+        cout << "  Alert " << alertId << " → notifying tier of " << tier.size() << ":";
+        for (const auto& contact : tier) cout << " " << contact.getName();
+        cout << " (" << message << ")" << endl;
+    });
+    time_t now = time(0);
+    cascadeEngine.start(*alerts[0], user, now);
+    cascadeEngine.tick(now + 30);  // Still inside the first tier's window
+    cascadeEngine.tick(now + 60);  // Nobody answered: escalate
+    cascadeEngine.acknowledge(alerts[0]->getId());
+    cascadeEngine.tick(now + 120); // Acknowledged: no further tiers
+    
+    // Thousands of cascades share one timer queue and one thread
+    long bulkNotified = 0;
+    CascadeEngine bulkEngine(60, [&bulkNotified](const string&, const string&, const vector<Contact>& tier) {
+        bulkNotified += tier.size();
+    });
+    auto sharedContacts = make_shared<const vector<Contact>>(vector<Contact>{
+        Contact("Primary", "+17770001", "", "Family", "", 2),
+        Contact("Backup", "+18880001", "", "Friend", "", 1)
+    });
+    for (int i = 0; i < 5000; i++) {
+        SMSAlert memberAlert("member" + to_string(i), "Help needed", emergencyLocation, {});
+        bulkEngine.start(memberAlert, sharedContacts, now);
+        if (i % 2 == 0) bulkEngine.acknowledge(memberAlert.getId());
+    }
+    bulkEngine.tick(now + 60);
+    cout << "Bulk cascades: 5000 started, " << bulkNotified << " notifications, "
+         << bulkEngine.activeCount() << " still active" << endl;
+    
+    // CONCURRENCY: Stress the queue and the worker pool from many threads
+    cout << "\n\n========== 11. CONCURRENCY CORE ==========" << endl;
+    BoundedMPMCQueue<long> ring(1024);
+    atomic<long> consumedSum(0);
+    atomic<int> producersDone(0);
+    const long itemsPerProducer = 100000;
+    vector<thread> stressThreads;
+    for (int p = 0; p < 4; p++) {
+        stressThreads.emplace_back([&]() {
+            for (long i = 1; i <= itemsPerProducer; i++) {
+                while (!ring.tryPush(i)) this_thread::yield();
+            }
+            producersDone++;
+        });
+        stressThreads.emplace_back([&]() {
+            long value;
+            while (true) {
+                if (ring.tryPop(value)) {
+                    consumedSum += value;
+                } else if (producersDone.load() == 4) {
+                    if (!ring.tryPop(value)) break;
+                    consumedSum += value;
+                }
+            }
+        });
+    }
+    for (auto& t : stressThreads) t.join();
+    long expectedSum = 4 * itemsPerProducer * (itemsPerProducer + 1) / 2;
+    cout << "MPMC queue: 4 producers x 4 consumers, sum "
+         << (consumedSum.load() == expectedSum ? "matches" : "MISMATCH") << endl;
+    
+    atomic<int> tasksRun(0);
+    {
+        WorkerPool pool(4);
+        auto poolStart = chrono::steady_clock::now();
+        for (int i = 0; i < 20000; i++) {
+            while (!pool.submit([&tasksRun]() { tasksRun++; })) this_thread::yield();
+        }
+        pool.waitIdle();
+        double poolSeconds = chrono::duration<double>(chrono::steady_clock::now() - poolStart).count();
+        cout << "Worker pool: " << tasksRun.load() << " tasks on " << pool.size() << " threads in "
+             << poolSeconds * 1000 << " ms" << endl;
+    }
+    
+    // BUILD COST: Construction and recipient iteration for many few-recipient
+    // alerts (heap allocation counts: see oop-code-alloc-bench.cpp)
+    cout << "\n\n========== 12. ALERT BUILD COST ==========" << endl;
+    {
+        const vector<string> phones = {"+1234567891", "+1234567892", "+1234567893"};
+        const SharedText notice = "Evacuate now";         // Interned once for the whole broadcast
+        const SharedLocation noticeLocation = emergencyLocation;
+        long recipientsSeen = 0;
+        auto buildStart = chrono::steady_clock::now();
+        for (int i = 0; i < 100000; i++) {
+            SMSAlert bulkAlert(user.getUserId(), notice, noticeLocation, {});
+            for (const auto& phone : phones) bulkAlert.addPhoneNumber(phone);
+            recipientsSeen += bulkAlert.recipientCount();
+        }
+        double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - buildStart).count();
+        cout << "Built 100000 SMS alerts (" << recipientsSeen << " recipients) in " << buildSeconds * 1000
+             << " ms" << endl;
+    }
+    
+    // CREDENTIALS: Hashed passwords and a bounded verification pool
+    cout << "\n\n========== 13. CREDENTIALS ==========" << endl;
+    cout << "Stored hash: " << user.getPasswordHash().substr(0, 40) << "..." << endl;
+    auto loginStart = chrono::steady_clock::now();
+    bool loginOk = user.checkPassword("securepass123");
+    double loginMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loginStart).count();
+    cout << "Correct password: " << (loginOk ? "accepted" : "rejected") << " (" << (int)loginMs
+         << " ms at cost " << PasswordHasher::getDefaultCost() << ")" << endl;
+    cout << "Wrong password: " << (user.checkPassword("guess123") ? "accepted" : "rejected") << endl;
+    
+    // A login burst: excess checks are refused rather than queued
+    {
+        CredentialService credentials(2, 8);
+        atomic<int> verified(0);
+        int refused = 0;
+        for (int i = 0; i < 50; i++) {
+            if (!credentials.verifyAsync("securepass123", user.getPasswordHash(),
+                                         [&verified](bool ok) { if (ok) verified++; })) {
+                refused++;
+            }
+        }
+        credentials.waitIdle();
+        cout << "Login burst: 50 attempts, " << verified.load() << " verified, "
+             << refused << " refused (pool busy)" << endl;
+    }
+    
+    // SESSION TOKENS: Repeated triggers from one session skip the HMAC
+    cout << "\n\n========== 14. SESSION TOKENS ==========" << endl;
+    {
+        SessionTokenVerifier sessions("server-secret-key");
+        time_t issuedAt = time(0);
+        string token = sessions.issue(user.getUserId(), issuedAt, 3600);
+        string tokenUser;
+        auto verifyStart = chrono::steady_clock::now();
+        int accepted = 0;
+        for (int i = 0; i < 10000; i++) {
+            if (sessions.verify(token, issuedAt, tokenUser)) accepted++;
+        }
+        double verifyMs = chrono::duration<double, milli>(chrono::steady_clock::now() - verifyStart).count();
+        cout << "10000 triggers verified in " << verifyMs << " ms (" << sessions.cacheHits()
+             << " cache hits, " << sessions.cacheMisses() << " misses), user " << tokenUser << endl;
+        
+        string forged = token;
+        forged[forged.size() - 1] = forged.back() == '0' ? '1' : '0';
+        cout << "Tampered token: " << (sessions.verify(forged, issuedAt, tokenUser) ? "accepted" : "rejected") << endl;
+        sessions.revoke(token, issuedAt);
+        cout << "Revoked token: " << (sessions.verify(token, issuedAt, tokenUser) ? "accepted" : "rejected") << endl;
+        cout << "Expired token: " << (sessions.verify(sessions.issue(user.getUserId(), issuedAt, 60), issuedAt + 120, tokenUser)
+                                      ? "accepted" : "rejected") << endl;
+    }
+    
+    // DEBOUNCE: Five presses in a few seconds send one alert
+    cout << "\n\n========== 15. DEBOUNCE ==========" << endl;
+    {
+        AlertDebouncer debouncer(30);
+        time_t pressTime = time(0);
+        int dispatched = 0;
+        for (int press = 0; press < 5; press++) {
+            Location moving(40.7128 + press * 0.0001, -74.0060, "Times Square, New York");
+            auto pressAlert = make_shared<SMSAlert>(user.getUserId(), "Help! (press " + to_string(press + 1) + ")",
+                                                    moving, vector<string>{"+1234567891"});
+            if (debouncer.admit(pressAlert, pressTime + press)) dispatched++;
+        }
+        auto later = make_shared<SMSAlert>(user.getUserId(), "Help again", emergencyLocation, vector<string>{"+1234567891"});
+        if (debouncer.admit(later, pressTime + 120)) dispatched++;
+        cout << "6 presses, " << dispatched << " alerts dispatched, " << debouncer.mergedCount()
+             << " merged into the open alert" << endl;
+    }
+    
+    // SURGE: Ramp synthetic disaster traffic until the pipeline saturates
+    cout << "\n\n========== 16. SURGE SIMULATOR ==========" << endl;
+    {
+        SurgeConfig surge;
+        surge.disaster = true;
+        surge.bursty = true;
+        SurgeSimulator simulator(surge);
+        AlertFeed surgeFeed;
+        auto surgeDashboard = surgeFeed.subscribe("Disaster-Desk", FeedFilter(40.6, -74.1, 40.8, -73.9));
+        TraceRecorder recorder("alert_trace.bin");
+        simulator.runRamp({1000, 10000, 100000, 1000000}, 5000, surgeFeed, &recorder);
+        cout << "Dashboard queued " << surgeDashboard->pendingCount() << " events ("
+             << surgeDashboard->droppedCount() << " oldest dropped, dashboard not reading)" << endl;
+        cout << "Captured " << recorder.recordCount() << " triggers to alert_trace.bin" << endl;
+    }
+    
+    // TRACE REPLAY: Feed the captured surge back through the pipeline
+    cout << "\n\n========== 17. TRACE REPLAY ==========" << endl;
+    {
+        TraceReplayer replayer;
+        if (replayer.load("alert_trace.bin")) {
+            cout << "Loaded " << replayer.size() << " triggers spanning " << replayer.duration() << " s" << endl;
+            AlertFeed replayFeed;
+            replayer.replay(20, replayFeed);
+            replayer.replay(0, replayFeed);
+        }
+    }
+    
+    // HOT/COLD: Status scans touch only the dense hot records
+    cout << "\n\n========== 18. HOT/COLD ALERT TABLE ==========" << endl;
+    {
+        const int tableRows = 200000;
+        vector<shared_ptr<Alert>> objects;
+        AlertTable table;
+        objects.reserve(tableRows);
+        table.reserve(tableRows);
+        for (int i = 0; i < tableRows; i++) {
+            auto alert = make_shared<SMSAlert>("scan_user" + to_string(i % 5000), "Status scan test alert number " + to_string(i),
+                                               emergencyLocation, vector<string>{"+1234567891"});
+            if (i % 3 == 0) alert->setStatus("sent");
+            table.insert(*alert);
+            objects.push_back(alert);
+        }
+        
+        auto scanStart = chrono::steady_clock::now();
+        size_t objectPending = 0;
+        for (const auto& alert : objects) objectPending += alert->getStatus() == "pending";
+        double objectMs = chrono::duration<double, milli>(chrono::steady_clock::now() - scanStart).count();
+        
+        scanStart = chrono::steady_clock::now();
+        size_t tablePending = table.countByStatus(STATUS_PENDING);
+        double tableMs = chrono::duration<double, milli>(chrono::steady_clock::now() - scanStart).count();
+        
+        cout << "Pending alerts via shared_ptr<Alert> scan: " << objectPending << " in " << objectMs << " ms" << endl;
+        cout << "Pending alerts via hot record scan:        " << tablePending << " in " << tableMs << " ms" << endl;
+        cout << "Overdue (created before now + 1s): " << table.olderThan(time(0) + 1, STATUS_PENDING).size() << endl;
+    }
+    
+    // ALERT STORE: Pipeline stages pass 64-bit handles, not shared_ptr
+    cout << "\n\n========== 19. ALERT STORE ==========" << endl;
+    {
+        AlertStore store;
+        vector<AlertHandle> handles;
+        for (int i = 0; i < 1000; i++) {
+            unique_ptr<Alert> alert(new SMSAlert(
+                "store_user" + to_string(i), "Stored alert", emergencyLocation, vector<string>{"+1234567891"}));
+            alert->setOutput(nullptr); // Keep a thousand sends off the console
+            handles.push_back(store.add(move(alert)));
+        }
+        
+        // Send stage: worker threads pop handles, send through them and
+        // pass them back. Only this (owning) thread writes statuses.
+        BoundedMPMCQueue<AlertHandle> toSend(256), sentBack(256);
+        atomic<int> sentByWorkers(0);
+        const int senders = 4;
+        vector<thread> sendStage;
+        for (int t = 0; t < senders; t++) {
+            sendStage.emplace_back([&]() {
+                AlertHandle handle;
+                for (;;) {
+                    if (!toSend.tryPop(handle)) {
+                        this_thread::yield();
+                        continue;
+                    }
+                    if (handle == NO_ALERT) return; // One per worker marks the end
+                    if (store.send(handle)) sentByWorkers++;
+                    while (!sentBack.tryPush(handle)) this_thread::yield();
+                }
+            });
+        }
+        size_t queued = 0, synced = 0;
+        while (synced < handles.size()) {
+            AlertHandle handle;
+            if (queued < handles.size() && toSend.tryPush(handles[queued])) {
+                queued++;
+            } else if (sentBack.tryPop(handle)) {
+                store.syncStatus(handle);
+                synced++;
+            } else {
+                this_thread::yield();
+            }
+        }
+        for (int t = 0; t < senders; t++) {
+            while (!toSend.tryPush(NO_ALERT)) this_thread::yield();
+        }
+        for (auto& worker : sendStage) worker.join();
+        
+        AlertHandle removed = handles[10];
+        store.remove(removed);
+        AlertHandle reused = store.add(unique_ptr<Alert>(new SMSAlert(
+            "store_user_new", "Reuses the freed slot", emergencyLocation, vector<string>{"+1234567891"})));
+        store.dispatch(reused); // Sends and updates the hot record together
+        cout << "Sent by worker threads through handles: " << sentByWorkers.load()
+             << ", statuses synced by owner: " << synced << ", live alerts: " << store.size() << endl;
+        cout << "Removed handle is " << (store.get(removed) ? "still valid (BUG)" : "detected as stale")
+             << "; its slot was reused: " << ((uint32_t)reused == (uint32_t)removed ? "yes" : "no") << endl;
+        cout << "Hot table: " << store.getTable().countByStatus(STATUS_SENT) << " sent, "
+             << store.getTable().countByStatus(STATUS_PENDING) << " pending" << endl;
+    }
+    
+    // ADDRESSES: Normalize and fuzzy-match contact addresses
+    cout << "\n\n========== 20. ADDRESS MATCHING ==========" << endl;
+    {
+        AddressIndex addresses;
+        for (const auto& contact : user.getContacts()) addresses.addContact(contact);
+        const char* streets[] = {"Main St", "Oak Ave", "Elm Rd", "Park Blvd", "Lake Dr", "Hill Ln"};
+        for (int i = 0; i < 200000; i++) {
+            addresses.add(to_string(1 + i % 2000) + " " + streets[i % 6] + " Apt " + to_string(i / 2000),
+                          "resident" + to_string(i));
+        }
+        cout << "\"123 Main St.\" normalizes to \"" << AddressIndex::normalize("123 Main St.") << "\"" << endl;
+        for (const string query : {"123 Main Street", "132 Main St", "456 Oak St"}) {
+            auto searchStart = chrono::steady_clock::now();
+            auto found = addresses.search(query, 2);
+            double searchMs = chrono::duration<double, milli>(chrono::steady_clock::now() - searchStart).count();
+            cout << "  \"" << query << "\": " << found.size() << " matches in " << searchMs << " ms";
+            if (!found.empty()) {
+                cout << ", best: " << addresses.getLabel(found[0].record) << " at \""
+                     << addresses.getAddress(found[0].record) << "\" (distance " << found[0].distance << ")";
+            }
+            cout << endl;
+        }
+    }
+    
+    // CONTACT SEARCH: Prefix, infix and typo-tolerant lookups
+    cout << "\n\n========== 21. CONTACT SEARCH ==========" << endl;
+    {
+        ContactSearchIndex search;
+        for (const auto& contact : user.getContacts()) search.add(contact);
+        const char* firstNames[] = {"Alice", "Bob", "Carmen", "Dmitri", "Elena", "Farid", "Grace", "Hiro"};
+        const char* lastNames[] = {"Garcia", "Nguyen", "Okafor", "Petrov", "Rossi", "Tanaka", "Weber", "Smithson"};
+        for (int i = 0; i < 200000; i++) {
+            string first = firstNames[i % 8], last = lastNames[(i / 8) % 8];
+            search.add(Contact(first + " " + last + " " + to_string(i), "+1" + to_string(2000000000LL + i * 7919LL),
+                               first + "." + to_string(i) + "@email.com", "Neighbor", ""));
+        }
+        
+        auto show = [&search](const string& label, const vector<uint32_t>& ids, double ms) {
+            cout << "  " << label << ": " << ids.size() << " results in " << ms << " ms";
+            if (!ids.empty()) cout << ", first: " << search.get(ids[0]).getName() << " (" << search.get(ids[0]).getPhone() << ")";
+            cout << endl;
+        };
+        auto timed = [](function<vector<uint32_t>()> query, double& ms) {
+            auto start = chrono::steady_clock::now();
+            vector<uint32_t> ids = query();
+            ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+            return ids;
+        };
+        double ms;
+        vector<uint32_t> ids = timed([&]() { return search.prefixSearch("Ja"); }, ms);
+        show("prefix \"Ja\"", ids, ms);
+        ids = timed([&]() { return search.prefixSearch("+1 234"); }, ms);
+        show("phone prefix \"+1 234\"", ids, ms);
+        ids = timed([&]() { return search.infixSearch("hospital"); }, ms);
+        show("infix \"hospital\"", ids, ms);
+        ids = timed([&]() { return search.typoSearch("Smiht", 2); }, ms);
+        show("typo \"Smiht\"", ids, ms);
+        search.remove(0);
+        ids = timed([&]() { return search.prefixSearch("Jane"); }, ms);
+        show("prefix \"Jane\" after removing Jane", ids, ms);
+    }
+    
+    // SNAPSHOT: Save state in the background, restart from snapshot + log tail
+    cout << "\n\n========== 22. SNAPSHOT & FAST STARTUP ==========" << endl;
+    {
+        vector<User> population;
+        population.push_back(user);
+        for (int i = 0; i < 100000; i++) {
+            string n = to_string(i);
+            population.push_back(User::restore("pop_user" + n, "Resident " + n, "resident" + n + "@email.com",
+                                               "+1444" + n, user.getPasswordHash(), {
+                Contact::restore("pop_contact" + n + "a", "Family " + n, "+1445" + n, "", "Family", "", 2),
+                Contact::restore("pop_contact" + n + "b", "Friend " + n, "+1446" + n, "", "Friend", "", 1)
+            }));
+        }
+        map<string, string> alertStatus;
+        long index;
+        string alertId, status;
+        for (const auto& entry : replicatedLog.entriesAfter(0)) {
+            if (ReplicatedLog::parseEntry(entry, index, alertId, status)) alertStatus[alertId] = status;
+        }
+        
+        auto saveStart = chrono::steady_clock::now();
+        future<bool> saved = StateSnapshot::saveInBackground("state_snapshot.bin", population, alertStatus,
+                                                             replicatedLog.getCommitIndex());
+        double captureMs = chrono::duration<double, milli>(chrono::steady_clock::now() - saveStart).count();
+        // Writers carry on while the snapshot is written: more alerts reach the log
+        replicatedLog.appendBatch(alerts);
+        cout << "Snapshot captured in " << captureMs << " ms, written in background: "
+             << (saved.get() ? "ok" : "FAILED") << endl;
+        
+        vector<User> restoredUsers;
+        map<string, string> restoredStatus;
+        auto loadStart = chrono::steady_clock::now();
+        bool restored = restoreState("state_snapshot.bin", replicatedLog, restoredUsers, restoredStatus);
+        double loadMs = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+        cout << "Restart: " << (restored ? "restored " : "FAILED ") << restoredUsers.size() << " users and "
+             << restoredStatus.size() << " alert statuses in " << loadMs << " ms" << endl;
+        if (restored && restoredUsers[0].checkPassword("securepass123")) {
+            cout << "Restored " << restoredUsers[0].getName() << " can still log in" << endl;
+        }
+    }
+    
+    // INCIDENT FAN-OUT: Duplicate contact details and opt-outs
+    cout << "\n\n========== 23. INCIDENT FAN-OUT ==========" << endl;
+    {
+        User household = User::restore("household_user", "Ana Lopez", "ana@email.com", "+1555000100",
+                                       user.getPasswordHash(), {
+            Contact::restore("hh_partner", "Luis Lopez", "+1 (555) 000-101", "Luis@Email.com", "Partner", "", 3),
+            Contact::restore("hh_partner_work", "Luis (work)", "+15550001 01", "luis@email.com ", "Partner", "", 2),
+            Contact::restore("hh_neighbor", "Neighbor", "+1555000102", "neighbor@email.com", "Neighbor", "", 1)
+        });
+        FanOutPlanner householdPlanner;
+        householdPlanner.optOut("hh_neighbor", CHANNEL_EMAIL);
+        householdPlanner.registerDevice("hh_partner", "token_luis_phone");
+        householdPlanner.registerDevice("hh_partner_work", "token_luis_phone");
+        
+        Incident fire = householdPlanner.open(household, "Smoke alarm at home, please call", Location(40.73, -73.99, "Home"));
+        fire.displayPlan();
+        for (const auto& alert : fire.createAlerts()) {
+            cout << alert->getAlertDetails() << endl;
+        }
+    }
+    
+    // INTERNED VALUES: One building-wide notice, many alerts
+    cout << "\n\n========== 24. SHARED MESSAGE BODIES ==========" << endl;
+    {
+        size_t textsBefore = SharedText::pool().liveCount();
+        vector<unique_ptr<Alert>> evacuation;
+        evacuation.reserve(10000);
+        for (int i = 0; i < 10000; i++) {
+            // Each resident's alert is built from its own copy of the text,
+            // as a partner feed would deliver it; interning folds them together
+            string text = "Building evacuation: leave by the nearest stairwell, do not use elevators.";
+            Location lobby(40.7580, -73.9855, "1 Times Square, Main Lobby");
+            evacuation.emplace_back(new PushNotificationAlert("resident" + to_string(i), move(text), move(lobby),
+                                                              {"token_" + to_string(i)}));
+        }
+        const Alert& first = *evacuation.front();
+        cout << "10000 evacuation alerts share " << SharedText::pool().liveCount() - textsBefore
+             << " new message body (" << first.getSharedMessage().useCount() << " references) and one location ("
+             << first.getSharedLocation().useCount() << " references)" << endl;
+        cout << "Duplicate text not stored: "
+             << (first.getMessage().size() + first.getLocation().getAddress().size()) * 9999
+             << " bytes" << endl;
+    }
+    
+    // AREA BROADCAST: Notify everyone inside a hazard zone
+    cout << "\n\n========== 25. AREA BROADCAST ==========" << endl;
+    {
+        const int residents = 200000;
+        LocationStore locations(residents);
+        vector<uint32_t> ids(residents);
+        for (int i = 0; i < residents; i++) locations.registerUser("resident" + to_string(i), ids[i]);
+        
+        // Phones report every few seconds while their owners walk around:
+        // four ingest threads, each owning a quarter of the users
+        const int ingestThreads = 4;
+        const int reportsPerThread = 2500000;
+        auto ingestStart = chrono::steady_clock::now();
+        vector<thread> ingest;
+        for (int t = 0; t < ingestThreads; t++) {
+            ingest.emplace_back([&, t]() {
+                mt19937 rng(t + 1);
+                uniform_real_distribution<double> lat(40.55, 40.90), lng(-74.10, -73.75), step(-0.0002, 0.0002);
+                vector<pair<double, double>> here;
+                for (int u = t; u < residents; u += ingestThreads) here.push_back({lat(rng), lng(rng)});
+                time_t now = time(0);
+                for (int i = 0; i < reportsPerThread; i++) {
+                    size_t mine = i % here.size();
+                    here[mine].first += step(rng);
+                    here[mine].second += step(rng);
+                    locations.update(ids[t + mine * ingestThreads], here[mine].first, here[mine].second, now, 10);
+                }
+            });
+        }
+        // Readers (e.g. responder proximity) query positions while ingest runs
+        atomic<bool> ingesting(true);
+        atomic<long> positionReads(0);
+        thread reader([&]() {
+            LocationStore::Position position;
+            long reads = 0;
+            for (uint32_t u = 0; ingesting.load(memory_order_relaxed); u = (u + 7919) % residents) {
+                reads += locations.read(ids[u], position);
+            }
+            positionReads = reads;
+        });
+        for (auto& worker : ingest) worker.join();
+        double ingestSeconds = chrono::duration<double>(chrono::steady_clock::now() - ingestStart).count();
+        ingesting = false;
+        reader.join();
+        cout << "Ingested " << ingestThreads * reportsPerThread << " position reports for " << locations.userCount()
+             << " users at " << (long)(ingestThreads * reportsPerThread / ingestSeconds) << " updates/sec ("
+             << positionReads.load() << " concurrent lock-free reads)" << endl;
+        
+        AreaBroadcaster broadcaster(locations, 1000, 2000);
+        size_t delivered = 0;
+        auto count = [&](unique_ptr<PushNotificationAlert> alert) { delivered += alert->recipientCount(); };
+        
+        CircleArea chemicalLeak(40.7580, -73.9855, 2000);
+        BroadcastStats leak = broadcaster.broadcast("hazard_chemical", chemicalLeak,
+            "Chemical leak: shelter in place, close windows", Location(40.7580, -73.9855, "Midtown"), count);
+        cout << "Chemical leak (2 km circle): " << leak.recipients << " of " << leak.candidates
+             << " candidates in " << leak.cellsVisited << " cells, " << leak.batches << " batches; first batch after "
+             << leak.firstBatchMs << " ms, done in " << leak.totalMs << " ms" << endl;
+        
+        PolygonArea fireZone({{40.60, -74.05}, {40.68, -74.02}, {40.66, -73.95}, {40.59, -73.98}});
+        BroadcastStats fire = broadcaster.broadcast("hazard_fire", fireZone,
+            "Wildfire: evacuate south-west Brooklyn now", Location(40.63, -74.0, "Bay Ridge"), count);
+        cout << "Fire zone (polygon): " << fire.recipients << " of " << fire.candidates
+             << " candidates in " << fire.cellsVisited << " cells, " << fire.batches << " batches; first batch after "
+             << fire.firstBatchMs << " ms, done in " << fire.totalMs << " ms" << endl;
+        cout << "Recipients handed to push alerts: " << delivered << endl;
+    }
+    
+    // ROUTING RULES: Channels chosen by a config file, reloaded live
+    cout << "\n\n========== 26. ROUTING RULES ==========" << endl;
+    {
+        {
+            ofstream config("routing_rules.conf", ios::trunc);
+            config << "# Channel routing\n"
+                   << "always -> +sms +email\n"
+                   << "when type=medical and severity>=4 -> +sms +voice +authority\n"
+                   << "when type=fire or type=police -> +authority +push\n"
+                   << "when type=general -> =push\n"
+                   << "when hour>=22 or hour<6 -> -email\n";
+        }
+        RoutingEngine router;
+        router.reload("routing_rules.conf");
+        cout << "Loaded " << router.current()->ruleCount() << " routing rules" << endl;
+        
+        time_t now = time(0);
+        time_t noon = now + (12 - localTime(now).tm_hour) * 3600;
+        time_t night = noon + 11 * 3600;
+        struct { const char* type; int severity; time_t when; const char* label; } cases[] = {
+            {"medical", 5, noon, "medical, severity 5, noon"},
+            {"medical", 2, night, "medical, severity 2, 11pm"},
+            {"fire", 3, noon, "fire, severity 3, noon"},
+            {"general", 1, noon, "general, severity 1, noon"}
+        };
+        for (const auto& c : cases) {
+            cout << "  " << c.label << " -> "
+                 << RoutingEngine::describe(router.route(RoutingContext::make(c.type, c.severity, c.when))) << endl;
+        }
+        unsigned medicalChannels = router.route(RoutingContext::make("medical", 5, noon));
+        cout << "Alerts from the section 3 incident for that route: " << incident.createAlerts(medicalChannels).size()
+             << " of " << incident.createAlerts().size() << endl;
+        unsigned unbuilt = Incident::unbuiltChannels(medicalChannels);
+        if (unbuilt) {
+            cout << "Routed but raised separately (not built from the plan): "
+                 << RoutingEngine::describe(unbuilt) << endl;
+        }
+        
+        // Evaluation cost, with the rule set taken once as a dispatch loop would
+        vector<RoutingContext> contexts;
+        const char* types[] = {"medical", "fire", "police", "general"};
+        for (int i = 0; i < 1024; i++) {
+            contexts.push_back(RoutingContext::make(types[i % 4], 1 + i % 5, noon + (i % 24) * 3600));
+        }
+        shared_ptr<const RuleSet> rules = router.current();
+        unsigned checksum = 0;
+        auto evalStart = chrono::steady_clock::now();
+        for (int i = 0; i < 10000000; i++) checksum += rules->evaluate(contexts[i & 1023]);
+        double evalNs = chrono::duration<double, nano>(chrono::steady_clock::now() - evalStart).count() / 10000000;
+        cout << "Rule evaluation: " << evalNs << " ns each (checksum " << checksum << ")" << endl;
+        
+        // Reload while a dispatcher keeps routing
+        atomic<bool> dispatching(true);
+        atomic<long> routed(0);
+        thread dispatcher([&]() {
+            long count = 0;
+            while (dispatching.load(memory_order_relaxed)) {
+                router.route(contexts[count & 1023]);
+                count++;
+            }
+            routed = count;
+        });
+        {
+            ofstream config("routing_rules.conf", ios::trunc);
+            config << "always -> +sms +push\n"
+                   << "when type=medical and severity>=4 -> +voice +authority\n";
+        }
+        bool reloaded = router.reload("routing_rules.conf");
+        {
+            ofstream config("routing_rules.conf", ios::app);
+            config << "when severity>>3 -> +sms\n";
+        }
+        bool rejected = !router.reload("routing_rules.conf");
+        this_thread::sleep_for(chrono::milliseconds(20));
+        dispatching = false;
+        dispatcher.join();
+        cout << "Reloaded rules: " << (reloaded ? "ok" : "FAILED") << ", broken file "
+             << (rejected ? "rejected, previous rules kept" : "ACCEPTED") << "; dispatcher routed "
+             << routed.load() << " alerts meanwhile" << endl;
+        cout << "  medical, severity 5, noon -> "
+             << RoutingEngine::describe(router.route(RoutingContext::make("medical", 5, noon))) << endl;
+    }
+    
     // Final summary
     cout << "\n\n╔════════════════════════════════════════════════════════╗" << endl;
     cout << "║              OOP CONCEPTS DEMONSTRATED:                ║" << endl;
@@ -485,7 +5228,14 @@ int main() {
  * COMPILATION AND EXECUTION:
  * 
  * To compile this C++ program:
- *   g++ -std=c++14 oop-code.cpp -o emergency-system
+ *   g++ -std=c++14 -pthread oop-code.cpp -o emergency-system
+ * 
+ * To count heap allocations per alert (replaces the global allocator,
+ * so it is kept out of the main program):
+ *   g++ -std=c++14 -pthread -O2 oop-code-alloc-bench.cpp -o alloc-bench
+ * 
+ * To check the concurrent code for data races:
+ *   g++ -std=c++14 -pthread -g -fsanitize=thread oop-code.cpp -o emergency-system
  * 
  * To run:
  *   ./emergency-system